@@ -33,5 +33,5 @@ button2.pack()
 button3 = tkinter.Button(window, text="Start the timer", command=update, font='Helvetica 20', width=20)
 button3.pack()
 
-events_tcltk.simple()
+events_tcltk.simple(window.tk.interpaddr())
 events_tcltk.start()
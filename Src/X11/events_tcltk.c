@@ -18,9 +18,6 @@
 #include "tcl.h"
 #include "tk.h"
 
-static TimerEventRec *freeTimerRecs;
-static WorkProcRec *freeWorkRecs;
-
 
 #define IeCallProc(ptr) \
     (*ptr->ie_proc) (ptr->ie_closure, &ptr->ie_source, (XtInputId*)&ptr);
@@ -85,20 +82,16 @@ static WorkProcRec *freeWorkRecs;
             (dest).tv_sec --;(dest).tv_usec += 1000000; } } }
 
 
-static PyThread_type_lock tcl_lock = 0;
-
 extern Tcl_ThreadDataKey state_key;
 typedef PyThreadState *ThreadSpecificData;
 
 #define ENTER_TCL \
     { PyThreadState *tstate = PyThreadState_Get(); \
       Py_BEGIN_ALLOW_THREADS \
-      if(tcl_lock)PyThread_acquire_lock(tcl_lock, 1); \
       (*(PyThreadState**)Tcl_GetThreadData(&state_key, sizeof(PyThreadState*))) = tstate;
 
 #define LEAVE_TCL \
     (*(PyThreadState**)Tcl_GetThreadData(&state_key, sizeof(PyThreadState*))) = NULL; \
-    if(tcl_lock)PyThread_release_lock(tcl_lock); \
     Py_END_ALLOW_THREADS}
 
 
@@ -134,12 +127,65 @@ typedef struct {
 				 * the event is queued). */
 } FileHandlerEvent;
 
+/*
+ * Timers added through MyXtAppAddTimeOut are kept in a binary heap ordered
+ * on te_timer_value instead of the sorted app->timerQueue list, so that
+ * adding and removing a timer is O(log n) in the number of pending timers.
+ * Each record remembers its position in the heap; te_next is not used.
+ * Timers added through the stock
+ * XtAppAddTimeOut still live on app->timerQueue, and MyNextTimer picks the
+ * earlier of the two.
+ */
+
+typedef struct {
+    TimerEventRec te;           /* must be first; XtIntervalId points here */
+    int index;                  /* position in timers.heap, or -1 */
+    Boolean rearmable;          /* owned by the caller, never freed */
+} HeapTimerRec;
+
+static struct TimerHeap {
+    HeapTimerRec **heap;
+    int count;
+    int size;
+} timers = {NULL, 0, 0};
+
+/*
+ * Work procedures added through MyXtAppAddWorkProc carry a priority.  They
+ * are kept on a list sorted by decreasing priority, and procedures of equal
+ * priority take turns.  Work procedures on the stock app->workQueue run at
+ * priority 0, taking turns with ours of that priority.  When the loop is
+ * idle, work procedures are called until the time slice is used up or input
+ * arrives.
+ */
+
+typedef struct {
+    WorkProcRec wp;             /* must be first; XtWorkProcId points here */
+    int priority;
+} PriorityWorkProcRec;
+
+static struct WorkQueue {
+    PriorityWorkProcRec *first;
+    PriorityWorkProcRec *running; /* Procedure being called, if any */
+    Boolean running_removed;    /* It was removed while being called */
+    Boolean stock_turn;         /* app->workQueue runs next at priority 0 */
+    struct timeval slice;       /* Longest run of work procedures */
+    unsigned long calls;        /* Work procedure calls */
+    unsigned long slices;       /* Runs of work procedures */
+    unsigned long preempted;    /* Runs cut short by pending input */
+    struct timeval work_time;   /* Time spent in work procedures */
+    struct timeval idle_time;   /* Time spent blocked waiting for input */
+} work = {NULL, NULL, False, False, {0, 10000}, 0, 0, 0, {0, 0}, {0, 0}};
+
 static struct NotifierState {
     XtAppContext appContext;	/* The context used by the Xt notifier. */
     XtIntervalId currentTimeout;/* Handle of current timer. */
     FileHandler *firstFileHandlerPtr;
 				/* Pointer to head of file handler list. */
-} notifier = {NULL, 0, NULL};
+    HeapTimerRec timer;		/* Timer record re-armed by SetTimer. */
+    Display *sharedDisplay;	/* Tk's display, if Xt was initialized on
+				 * it; events on it are shared out between
+				 * Tk windows and Xt widgets. */
+} notifier = {NULL, 0, NULL, {{{0, 0}, NULL, NULL, NULL, NULL}, -1, TRUE}, NULL};
 
 typedef struct {
     struct timeval cur_time;
@@ -169,6 +215,70 @@ typedef struct {
 
 static struct timeval zero_time = { 0, 0 };
 
+/*
+ * Input, timer and work procedure records come from a pool per record type.
+ * A pool hands out records from its free list and carves a chunk of
+ * POOL_CHUNK new records when the list runs out, so that a loop which keeps
+ * adding and removing them does not call malloc in steady state.  Records
+ * are never given back to malloc.
+ */
+
+#define POOL_CHUNK 32
+
+typedef struct {
+    const char *name;
+    size_t size;                /* Record size, at least a pointer */
+    void *free;                 /* Free records, linked through first word */
+    unsigned long hits;         /* Allocations served from the free list */
+    unsigned long misses;       /* Allocations that needed a new chunk */
+    unsigned long in_use;
+} RecordPool;
+
+static RecordPool pools[] = {
+#define INPUT_POOL (&pools[0])
+    {"input", sizeof(InputEvent), NULL, 0, 0, 0},
+#define TIMER_POOL (&pools[1])
+    {"timer", sizeof(HeapTimerRec), NULL, 0, 0, 0},
+#define WORK_POOL (&pools[2])
+    {"work", sizeof(PriorityWorkProcRec), NULL, 0, 0, 0},
+};
+
+static void *
+MyPoolAlloc(RecordPool *pool)
+{
+    void **ptr;
+
+    LOCK_PROCESS;
+    if (pool->free == NULL) {
+        char *chunk = XtMalloc((Cardinal) (POOL_CHUNK * pool->size));
+        int i;
+
+        for (i = POOL_CHUNK; i-- > 0;) {
+            ptr = (void **) (chunk + (size_t) i * pool->size);
+            *ptr = pool->free;
+            pool->free = ptr;
+        }
+        pool->misses++;
+    }
+    else
+        pool->hits++;
+    ptr = (void **) pool->free;
+    pool->free = *ptr;
+    pool->in_use++;
+    UNLOCK_PROCESS;
+    return ptr;
+}
+
+static void
+MyPoolFree(RecordPool *pool, void *record)
+{
+    LOCK_PROCESS;
+    *(void **) record = pool->free;
+    pool->free = record;
+    pool->in_use--;
+    UNLOCK_PROCESS;
+}
+
 static XtInputId
 MyXtAppAddInput(XtAppContext app,
               int source,
@@ -200,7 +310,7 @@ MyXtAppAddInput(XtAppContext app,
             app->input_list[ii] = (InputEvent *) NULL;
         app->input_max = (short) n;
     }
-    sptr = XtNew(InputEvent);
+    sptr = (InputEvent *) MyPoolAlloc(INPUT_POOL);
 
     sptr->ie_proc = proc;
     sptr->ie_closure = closure;
@@ -232,78 +342,240 @@ MyXtAppAddInput(XtAppContext app,
 }
 
 static void
-MyQueueTimerEvent(XtAppContext app, TimerEventRec *ptr)
+MyXtRemoveInput(register XtInputId id)
 {
-    TimerEventRec *t, **tt;
+    register InputEvent *sptr, *lptr;
+    XtAppContext app = ((InputEvent *) id)->app;
+    register int source = ((InputEvent *) id)->ie_source;
+    Boolean found = False;
+
+    LOCK_APP(app);
+    sptr = app->outstandingQueue;
+    lptr = NULL;
+    for (; sptr != NULL; sptr = sptr->ie_oq) {
+        if (sptr == (InputEvent *) id) {
+            if (lptr == NULL)
+                app->outstandingQueue = sptr->ie_oq;
+            else
+                lptr->ie_oq = sptr->ie_oq;
+        }
+        lptr = sptr;
+    }
+
+    if (app->input_list && (sptr = app->input_list[source]) != NULL) {
+        for (lptr = NULL; sptr; sptr = sptr->ie_next) {
+            if (sptr == (InputEvent *) id) {
+#ifndef USE_POLL
+                XtInputMask condition = 0;
+#endif
+                if (lptr == NULL) {
+                    app->input_list[source] = sptr->ie_next;
+                }
+                else {
+                    lptr->ie_next = sptr->ie_next;
+                }
+#ifndef USE_POLL
+                for (lptr = app->input_list[source]; lptr; lptr = lptr->ie_next)
+                    condition |= lptr->ie_condition;
+                if ((sptr->ie_condition & XtInputReadMask) &&
+                    !(condition & XtInputReadMask))
+                    FD_CLR(source, &app->fds.rmask);
+                if ((sptr->ie_condition & XtInputWriteMask) &&
+                    !(condition & XtInputWriteMask))
+                    FD_CLR(source, &app->fds.wmask);
+                if ((sptr->ie_condition & XtInputExceptMask) &&
+                    !(condition & XtInputExceptMask))
+                    FD_CLR(source, &app->fds.emask);
+#endif
+                MyPoolFree(INPUT_POOL, sptr);
+                found = True;
+                break;
+            }
+            lptr = sptr;
+        }
+    }
 
-    tt = &app->timerQueue;
-    t = *tt;
-    while (t != NULL && IS_AFTER(t->te_timer_value, ptr->te_timer_value)) {
-        tt = &t->te_next;
-        t = *tt;
+    if (found) {
+        app->input_count--;
+#ifdef USE_POLL
+        if (app->input_list[source] == NULL)
+            app->fds.nfds--;
+#endif
+        app->rebuild_fdlist = TRUE;
     }
-    ptr->te_next = t;
-    *tt = ptr;
+    else
+        XtAppWarningMsg(app, "invalidProcedure", "inputHandler",
+                        XtCXtToolkitError,
+                        "XtRemoveInput: Input handler not found", NULL, NULL);
+    UNLOCK_APP(app);
 }
 
-static XtIntervalId MyXtAppAddTimeOut(XtAppContext app, unsigned long interval, XtTimerCallbackProc proc, XtPointer closure)
+static void
+MyTimerHeapSet(int i, HeapTimerRec *ptr)
 {
-    TimerEventRec *tptr;
-    struct timeval current_time;
+    timers.heap[i] = ptr;
+    ptr->index = i;
+}
 
-    LOCK_APP(app);
-    LOCK_PROCESS;
-    if (freeTimerRecs) {
-        tptr = freeTimerRecs;
-        freeTimerRecs = tptr->te_next;
+static void
+MyTimerHeapSiftUp(int i)
+{
+    HeapTimerRec *ptr = timers.heap[i];
+
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+
+        if (!IS_AFTER(ptr->te.te_timer_value,
+                      timers.heap[parent]->te.te_timer_value))
+            break;
+        MyTimerHeapSet(i, timers.heap[parent]);
+        i = parent;
     }
-    else
-        tptr = XtNew(TimerEventRec);
+    MyTimerHeapSet(i, ptr);
+}
+
+static void
+MyTimerHeapSiftDown(int i)
+{
+    HeapTimerRec *ptr = timers.heap[i];
+
+    while (1) {
+        int child = 2 * i + 1;
+
+        if (child >= timers.count)
+            break;
+        if (child + 1 < timers.count &&
+            IS_AFTER(timers.heap[child + 1]->te.te_timer_value,
+                     timers.heap[child]->te.te_timer_value))
+            child++;
+        if (!IS_AFTER(timers.heap[child]->te.te_timer_value,
+                      ptr->te.te_timer_value))
+            break;
+        MyTimerHeapSet(i, timers.heap[child]);
+        i = child;
+    }
+    MyTimerHeapSet(i, ptr);
+}
+
+static void
+MyQueueTimerEvent(XtAppContext app _X_UNUSED, HeapTimerRec *ptr)
+{
+    if (timers.count == timers.size) {
+        timers.size = timers.size ? 2 * timers.size : 16;
+        timers.heap = (HeapTimerRec **) XtRealloc((char *) timers.heap,
+                                                  (Cardinal) ((size_t) timers.size *
+                                                              sizeof(HeapTimerRec *)));
+    }
+    timers.heap[timers.count] = ptr;
+    MyTimerHeapSiftUp(timers.count++);
+}
+
+static void
+MyDequeueTimerEvent(HeapTimerRec *ptr)
+{
+    HeapTimerRec *last;
+    int i = ptr->index;
+
+    ptr->index = -1;
+    if (--timers.count == i)
+        return;
+    last = timers.heap[timers.count];
+    MyTimerHeapSet(i, last);
+    MyTimerHeapSiftUp(i);
+    MyTimerHeapSiftDown(last->index);
+}
+
+static void
+MySetTimerValue(TimerEventRec *tptr, unsigned long interval)
+{
+    struct timeval current_time;
 
-    UNLOCK_PROCESS;
-    tptr->te_next = NULL;
-    tptr->te_closure = closure;
-    tptr->te_proc = proc;
-    tptr->app = app;
     tptr->te_timer_value.tv_sec = (time_t) (interval / 1000);
     tptr->te_timer_value.tv_usec = (suseconds_t) ((interval % 1000) * 1000);
     X_GETTIMEOFDAY(&current_time);
     FIXUP_TIMEVAL(current_time);
     ADD_TIME(tptr->te_timer_value, tptr->te_timer_value, current_time);
+}
+
+static XtIntervalId MyXtAppAddTimeOut(XtAppContext app, unsigned long interval, XtTimerCallbackProc proc, XtPointer closure)
+{
+    HeapTimerRec *tptr;
+
+    LOCK_APP(app);
+    tptr = (HeapTimerRec *) MyPoolAlloc(TIMER_POOL);
+    tptr->te.te_next = NULL;
+    tptr->te.te_closure = closure;
+    tptr->te.te_proc = proc;
+    tptr->te.app = app;
+    tptr->rearmable = FALSE;
+    MySetTimerValue(&tptr->te, interval);
     MyQueueTimerEvent(app, tptr);
     UNLOCK_APP(app);
 
     return ((XtIntervalId) tptr);
 }
 
+/*
+ * Arms a caller-owned timer record, or moves its deadline if it is already
+ * pending.  The record is updated in place in the heap, so re-arming costs
+ * no allocation and no search.
+ */
+static XtIntervalId MyXtAppRearmTimeOut(XtAppContext app, HeapTimerRec *tptr, unsigned long interval, XtTimerCallbackProc proc, XtPointer closure)
+{
+    LOCK_APP(app);
+    tptr->te.te_next = NULL;
+    tptr->te.te_closure = closure;
+    tptr->te.te_proc = proc;
+    tptr->te.app = app;
+    tptr->rearmable = TRUE;
+    MySetTimerValue(&tptr->te, interval);
+    if (tptr->index < 0)
+        MyQueueTimerEvent(app, tptr);
+    else {
+        MyTimerHeapSiftUp(tptr->index);
+        MyTimerHeapSiftDown(tptr->index);
+    }
+    UNLOCK_APP(app);
+
+    return ((XtIntervalId) tptr);
+}
+
 static void MyXtRemoveTimeOut(XtIntervalId id)
 {
-    TimerEventRec *t, *last, *tid = (TimerEventRec *) id;
-    XtAppContext app = tid->app;
+    HeapTimerRec *tid = (HeapTimerRec *) id;
+    XtAppContext app = tid->te.app;
 
-    /* find it */
     LOCK_APP(app);
-    for (t = app->timerQueue, last = NULL;
-         t != NULL && t != tid; t = t->te_next)
-        last = t;
-
-    if (t == NULL) {
+    if (tid->index < 0) {
         UNLOCK_APP(app);
-        return;                 /* couldn't find it */
+        return;                 /* already fired or removed */
     }
-    if (last == NULL) {         /* first one on the list */
-        app->timerQueue = t->te_next;
-    }
-    else
-        last->te_next = t->te_next;
+    MyDequeueTimerEvent(tid);
 
-    LOCK_PROCESS;
-    t->te_next = freeTimerRecs;
-    freeTimerRecs = t;
-    UNLOCK_PROCESS;
+    if (!tid->rearmable)
+        MyPoolFree(TIMER_POOL, tid);
     UNLOCK_APP(app);
 }
 
+/*
+ * Returns the timer that expires first, whether it lives in our heap or on
+ * the stock app->timerQueue, and sets *in_heap accordingly.
+ */
+static TimerEventRec *
+MyNextTimer(XtAppContext app, Boolean *in_heap)
+{
+    TimerEventRec *t = app->timerQueue;
+
+    *in_heap = FALSE;
+    if (timers.count > 0 &&
+        (t == NULL || !IS_AFTER(t->te_timer_value,
+                                timers.heap[0]->te.te_timer_value))) {
+        t = &timers.heap[0]->te;
+        *in_heap = TRUE;
+    }
+    return t;
+}
+
 
 static void MyFindInputs1(XtAppContext app, wait_fds_ptr_t wf, int nfds _X_UNUSED, int *dpy_no, int *found_input)
 {
@@ -742,10 +1014,13 @@ static int MyIoWait(wait_times_ptr_t wt, wait_fds_ptr_t wf)
 
 static void MyAdjustTimes(XtAppContext app, wait_times_ptr_t wt)
 {
-    if (app->timerQueue != NULL) {
+    Boolean in_heap;
+    TimerEventRec *next = MyNextTimer(app, &in_heap);
+
+    if (next != NULL) {
 #ifdef USE_POLL
-        if (IS_AFTER(wt->cur_time, app->timerQueue->te_timer_value)) {
-            TIMEDELTA(wt->wait_time, app->timerQueue->te_timer_value,
+        if (IS_AFTER(wt->cur_time, next->te_timer_value)) {
+            TIMEDELTA(wt->wait_time, next->te_timer_value,
                       wt->cur_time);
             wt->poll_wait =
                 (int) (wt->wait_time.tv_sec * 1000 +
@@ -754,8 +1029,8 @@ static void MyAdjustTimes(XtAppContext app, wait_times_ptr_t wt)
         else
             wt->poll_wait = X_DONT_BLOCK;
 #else
-        if (IS_AFTER(wt->cur_time, app->timerQueue->te_timer_value)) {
-            TIMEDELTA(wt->wait_time, app->timerQueue->te_timer_value,
+        if (IS_AFTER(wt->cur_time, next->te_timer_value)) {
+            TIMEDELTA(wt->wait_time, next->te_timer_value,
                       wt->cur_time);
             wt->wait_time_ptr = &wt->wait_time;
         }
@@ -910,11 +1185,19 @@ static int _MyXtWaitForSomething2(XtAppContext app)
 
         if (app->rebuild_fdlist) MyInitFds2(app, &wf);
 
+        X_GETTIMEOFDAY(&wt.start_time);
+        FIXUP_TIMEVAL(wt.start_time);
 #ifdef XTHREADS                 /* { */
         YIELD_APP_LOCK(app, &push_thread, &pushed_thread, &level);
         nfds = MyIoWait(&wt, &wf);
         RESTORE_APP_LOCK(app, level, &pushed_thread);
+#else                           /* }{ */
+        nfds = MyIoWait(&wt, &wf);
 #endif                          /* } */
+        X_GETTIMEOFDAY(&wt.new_time);
+        FIXUP_TIMEVAL(wt.new_time);
+        TIMEDELTA(wt.time_spent, wt.new_time, wt.start_time);
+        ADD_TIME(work.idle_time, work.idle_time, wt.time_spent);
         if (nfds == -1) {
             /*
              *  interrupt occured recalculate time value and wait again.
@@ -1016,6 +1299,9 @@ static int _MyXtWaitForSomething2(XtAppContext app)
 }
 
 
+/* Tabulates the keysym of every keycode and modifier state; in TMkey.c */
+extern void _XtBuildKeycodeTable(Display *dpy, XtPerDisplay pd);
+
 static void
 _MyXtBuildKeysymTables(Display *dpy, register XtPerDisplay pd)
 {
@@ -1108,9 +1394,13 @@ _MyXtBuildKeysymTables(Display *dpy, register XtPerDisplay pd)
         }
     }
     XFreeModifiermap(modKeymap);
+    _XtBuildKeycodeTable(dpy, pd);
 }
 
 
+/* Bumped to invalidate the translation match tables kept by TMstate.c */
+extern unsigned long _XtMatchTableGeneration;
+
 static void
 _MyXtRefreshMapping(XEvent *event)
 {
@@ -1118,6 +1408,7 @@ _MyXtRefreshMapping(XEvent *event)
 
     if(_XtProcessLock)(*_XtProcessLock)();
     pd = _XtGetPerDisplay(event->xmapping.display);
+    _XtMatchTableGeneration++;
 
     if (event->xmapping.request != MappingPointer &&
         pd && pd->keysyms && (event->xmapping.serial >= pd->keysyms_serial))
@@ -1146,10 +1437,6 @@ MyLookupSpringLoaded(XtGrabList grabList)
     return NULL;
 }
 
-/* keep this SMALL to avoid blowing stack cache! */
-/* because some compilers allocate all local locals on procedure entry */
-#define EHSIZE 4
-
 #define KnownButtons (Button1MotionMask|Button2MotionMask|Button3MotionMask|\
                       Button4MotionMask|Button5MotionMask)
 
@@ -1213,6 +1500,37 @@ MyAddExposureToRectangularRegion(XEvent *event,   /* when called internally, typ
 
 static Region nullRegion;
 
+/*
+ * When an Expose or GraphicsExpose event is read, the run of exposure
+ * events queued directly behind it is collected in one pass over the Xlib
+ * queue, and bucketed per window into an accumulated damage region.  Only
+ * widgets asking for XtExposeCompressMaximal take part, since only they
+ * allow their exposures to be taken out of order, and the run ends at the
+ * first other event so that nothing is moved ahead of it.  Buckets are
+ * found through an XContext on the window, so each widget's expose
+ * procedure then runs once with its full region, instead of every widget
+ * rescanning the whole queue with XCheckIfEvent in MyCompressExposures.
+ */
+
+typedef struct {
+    Display *dpy;
+    Window window;
+    Boolean pending[2];         /* Expose, GraphicsExpose */
+    XEvent event[2];            /* First event of each type for the window */
+    Region region[2];           /* Damage accumulated for each type */
+    int count[2];               /* Count of the last event of each type */
+} ExposeBucket;
+
+static struct ExposeIndex {
+    XContext context;           /* Maps a window to its bucket number + 1 */
+    ExposeBucket *buckets;      /* In order of first arrival */
+    int count;
+    int size;
+    Boolean active;             /* Buckets are being dispatched */
+} exposures = {0, NULL, 0, 0, FALSE};
+
+#define ExposeIndex(ev) ((ev)->type == GraphicsExpose ? 1 : 0)
+
 static void
 MySendExposureEvent(XEvent *event, Widget widget, XtPerDisplay pd)
 {   
@@ -1254,6 +1572,56 @@ MyCheckExposureEvent(Display *disp _X_UNUSED, XEvent *event, char *arg)
     return (FALSE);
 }
 
+/*
+ * If the pre-pass collected damage for this widget's window, moves it into
+ * region and returns the count of the last event taken, which is not zero
+ * if the rest of the series has not been read yet; the event itself is
+ * already part of the damage.  Returns -1 if there is no such damage.
+ */
+static int
+MyTakeExposeBucket(XEvent *event, Widget widget, Region region,
+                   Boolean no_region, XtEnum comp_expose)
+{
+    ExposeBucket *bucket;
+    XPointer data;
+    int i, j;
+    int count = 0;
+
+    if (!exposures.active)
+        return -1;
+    if (XFindContext(XtDisplay(widget), XtWindow(widget),
+                     exposures.context, &data) != 0)
+        return -1;
+    bucket = &exposures.buckets[(intptr_t) data - 1];
+    i = ExposeIndex(event);
+    if (!bucket->pending[i])
+        return -1;
+
+    for (j = 0; j < 2; j++) {
+        if (!bucket->pending[j])
+            continue;
+        if (j != i && !(comp_expose & XtExposeGraphicsExposeMerged))
+            continue;
+        bucket->pending[j] = False;
+        if (bucket->count[j] > count)
+            count = bucket->count[j];
+        if (no_region) {
+            XRectangle box;
+            XExposeEvent ev;
+
+            XClipBox(bucket->region[j], &box);
+            ev.x = box.x;
+            ev.y = box.y;
+            ev.width = box.width;
+            ev.height = box.height;
+            MyAddExposureToRectangularRegion((XEvent *) &ev, region);
+        }
+        else
+            XUnionRegion(bucket->region[j], region, region);
+    }
+    return count;
+}
+
 static void
 MyCompressExposures(XEvent *event, Widget widget)
 {
@@ -1271,18 +1639,31 @@ MyCompressExposures(XEvent *event, Widget widget)
     comp_expose_type = comp_expose & 0x0f;
     no_region = ((comp_expose & XtExposeNoRegion) ? True : False);
 
-    if (no_region)
-        MyAddExposureToRectangularRegion(event, pd->region);
-    else
-        XtAddExposureToRegion(event, pd->region);
+    count = MyTakeExposeBucket(event, widget, pd->region, no_region,
+                               comp_expose);
+    if (count >= 0) {
+        /* The widget is sent the event only once its series has ended */
+        GetCount(event) = 0;
+        if (count == 0) {
+            MySendExposureEvent(event, widget, pd);
+            return;
+        }
+    }
+    else {
+        if (no_region)
+            MyAddExposureToRectangularRegion(event, pd->region);
+        else
+            XtAddExposureToRegion(event, pd->region);
 
-    if (GetCount(event) != 0)
-        return;
+        if (GetCount(event) != 0)
+            return;
 
-    if ((comp_expose_type == XtExposeCompressSeries) ||
-        (XEventsQueued(dpy, QueuedAfterReading) == 0)) {
-        MySendExposureEvent(event, widget, pd);
-        return;
+        if ((comp_expose_type == XtExposeCompressSeries) ||
+            (XEventsQueued(dpy, QueuedAfterReading) == 0)) {
+            MySendExposureEvent(event, widget, pd);
+            return;
+        }
+        count = 0;
     }
 
     if (comp_expose & XtExposeGraphicsExposeMerged) {
@@ -1316,7 +1697,6 @@ MyCompressExposures(XEvent *event, Widget widget)
      * the event queue as a side-effect).
      */
 
-    count = 0;
     while (TRUE) {
         XEvent event_return;
 
@@ -1344,57 +1724,13 @@ MyCompressExposures(XEvent *event, Widget widget)
     MySendExposureEvent(event, widget, pd);
 }
 
-#define EXT_TYPE(p) (((XtEventRecExt*) ((p)+1))->type)
-
-typedef struct _XtEventRecExt {
-    int type;
-    XtPointer select_data[1];   /* actual dimension is [mask] */
-} XtEventRecExt;
-
-static Boolean
-MyCallEventHandlers(Widget widget, XEvent *event, EventMask mask)
-{
-    register XtEventRec *p;
-    XtEventHandler *proc;
-    XtPointer *closure;
-    Boolean cont_to_disp = True;
-    int i, numprocs;
-
-    /* Have to copy the procs into an array, because one of them might
-     * call XtRemoveEventHandler, which would break our linked list. */
-
-    numprocs = 0;
-    for (p = widget->core.event_table; p; p = p->next) {
-        if ((!p->has_type_specifier && (mask & p->mask)) ||
-            (p->has_type_specifier && event->type == EXT_TYPE(p)))
-            numprocs++;
-    }
-    proc = (XtEventHandler *)
-        __XtMalloc((Cardinal)
-                   ((size_t) numprocs *
-                    (sizeof(XtEventHandler) + sizeof(XtPointer))));
-    closure = (XtPointer *) (proc + numprocs);
-
-    numprocs = 0;
-    for (p = widget->core.event_table; p; p = p->next) {
-        if ((!p->has_type_specifier && (mask & p->mask)) ||
-            (p->has_type_specifier && event->type == EXT_TYPE(p))) {
-            proc[numprocs] = p->proc;
-            closure[numprocs] = p->closure;
-            numprocs++;
-        }
-    }
-    for (i = 0; i < numprocs && cont_to_disp; i++)
-        (*(proc[i])) (widget, closure[i], event, &cont_to_disp);
-    XtFree((char *) proc);
-    return cont_to_disp;
-}
-
+/* Calls the handlers that select the event through the per-widget index
+ * kept by Event.c, instead of walking the widget's whole event table. */
+extern Boolean _XtCallEventHandlers(Widget, XEvent*, EventMask, Boolean*);
 
 static Boolean
 MyXtDispatchEventToWidget(Widget widget, XEvent *event)
 {
-    register XtEventRec *p;
     Boolean was_dispatched = False;
     Boolean call_tm = False;
     Boolean cont_to_disp;
@@ -1459,45 +1795,8 @@ MyXtDispatchEventToWidget(Widget widget, XEvent *event)
         call_tm = True;
 
     cont_to_disp = True;
-    p = widget->core.event_table;
-    if (p) {
-        if (p->next) {
-            XtEventHandler proc[EHSIZE];
-            XtPointer closure[EHSIZE];
-            int numprocs = 0;
-
-            /* Have to copy the procs into an array, because one of them might
-             * call XtRemoveEventHandler, which would break our linked list. */
-
-            for (; p; p = p->next) {
-                if ((!p->has_type_specifier && (mask & p->mask)) ||
-                    (p->has_type_specifier && event->type == EXT_TYPE(p))) {
-                    if (numprocs >= EHSIZE)
-                        break;
-                    proc[numprocs] = p->proc;
-                    closure[numprocs] = p->closure;
-                    numprocs++;
-                }
-            }
-            if (numprocs) {
-                if (p) {
-                    cont_to_disp = MyCallEventHandlers(widget, event, mask);
-                }
-                else {
-                    int i;
-
-                    for (i = 0; i < numprocs && cont_to_disp; i++)
-                        (*(proc[i])) (widget, closure[i], event, &cont_to_disp);
-                }
-                was_dispatched = True;
-            }
-        }
-        else if ((!p->has_type_specifier && (mask & p->mask)) ||
-                 (p->has_type_specifier && event->type == EXT_TYPE(p))) {
-            (*p->proc) (widget, p->closure, event, &cont_to_disp);
-            was_dispatched = True;
-        }
-    }
+    if (_XtCallEventHandlers(widget, event, mask, &cont_to_disp))
+        was_dispatched = True;
     if (call_tm && cont_to_disp)
         _XtTranslateEvent(widget, event);
     UNLOCK_APP(app);
@@ -1530,84 +1829,265 @@ MyDispatchEvent(XEvent *event, Widget widget)
         }
     }
 
-    if (event->type == MotionNotify &&
-        widget->core.widget_class->core_class.compress_motion) {
-        while (XPending(event->xmotion.display)) {
-            XEvent nextEvent;
-            XPeekEvent(event->xmotion.display, &nextEvent);
-
-            if (nextEvent.type == MotionNotify &&
-                event->xmotion.window == nextEvent.xmotion.window &&
-                event->xmotion.subwindow == nextEvent.xmotion.subwindow) {
-                /* replace the current event with the next one */
-                XNextEvent(event->xmotion.display, event);
-            }
-            else
-                break;
-        }
-    }
+    /* MotionNotify events were already coalesced by MyCoalesceEvent */
 
     return MyXtDispatchEventToWidget(widget, event);
 }
 
-#define NonMaskableMask ((EventMask)0x80000000L)
+/*
+ * A widget class that sets compress_motion gets its runs of MotionNotify
+ * events coalesced, as in stock Xt.  Since compress_motion is a Boolean,
+ * the other kinds of coalescing are enabled per class with MySetCoalescing.
+ */
+#define MyCoalesceConfigure     0x01    /* Keep only the latest ConfigureNotify */
+#define MyCoalesceMotionHistory 0x02    /* Record coalesced MotionNotify events */
 
-static EventMask const masks[] = {
-    0,                          /* Error, should never see  */
-    0,                          /* Reply, should never see  */
-    KeyPressMask,               /* KeyPress                 */
-    KeyReleaseMask,             /* KeyRelease               */
-    ButtonPressMask,            /* ButtonPress              */
-    ButtonReleaseMask,          /* ButtonRelease            */
-    PointerMotionMask           /* MotionNotify             */
-        | ButtonMotionMask,
-    EnterWindowMask,            /* EnterNotify              */
-    LeaveWindowMask,            /* LeaveNotify              */
-    FocusChangeMask,            /* FocusIn                  */
-    FocusChangeMask,            /* FocusOut                 */
-    KeymapStateMask,            /* KeymapNotify             */
-    ExposureMask,               /* Expose                   */
-    NonMaskableMask,            /* GraphicsExpose, in GC    */
-    NonMaskableMask,            /* NoExpose, in GC          */
-    VisibilityChangeMask,       /* VisibilityNotify         */
-    SubstructureNotifyMask,     /* CreateNotify             */
-    StructureNotifyMask         /* DestroyNotify            */
-        | SubstructureNotifyMask,
-    StructureNotifyMask         /* UnmapNotify              */
-        | SubstructureNotifyMask,
-    StructureNotifyMask         /* MapNotify                */
-        | SubstructureNotifyMask,
-    SubstructureRedirectMask,   /* MapRequest               */
-    StructureNotifyMask         /* ReparentNotify           */
-        | SubstructureNotifyMask,
-    StructureNotifyMask         /* ConfigureNotify          */
-        | SubstructureNotifyMask,
-    SubstructureRedirectMask,   /* ConfigureRequest         */
-    StructureNotifyMask         /* GravityNotify            */
-        | SubstructureNotifyMask,
-    ResizeRedirectMask,         /* ResizeRequest            */
-    StructureNotifyMask         /* CirculateNotify          */
-        | SubstructureNotifyMask,
-    SubstructureRedirectMask,   /* CirculateRequest         */
-    PropertyChangeMask,         /* PropertyNotify           */
-    NonMaskableMask,            /* SelectionClear           */
-    NonMaskableMask,            /* SelectionRequest         */
-    NonMaskableMask,            /* SelectionNotify          */
-    ColormapChangeMask,         /* ColormapNotify           */
-    NonMaskableMask,            /* ClientMessage            */
-    NonMaskableMask             /* MappingNotify            */
-};
+typedef struct {
+    WidgetClass widget_class;
+    int flags;
+} CoalescingRec;
 
-static EventMask
-_MyXtConvertTypeToMask(int eventType)
+static struct {
+    CoalescingRec *classes;
+    int count;
+    int size;
+} coalescing = {NULL, 0, 0};
+
+static void
+MySetCoalescing(WidgetClass widget_class, int flags)
 {
-    if ((Cardinal) eventType < XtNumber(masks))
-        return masks[eventType];
-    else
-        return NoEventMask;
-}
-static Widget
-_MyXtFindRemapWidget(XEvent *event,
+    int i;
+
+    LOCK_PROCESS;
+    for (i = 0; i < coalescing.count; i++)
+        if (coalescing.classes[i].widget_class == widget_class)
+            break;
+    if (i == coalescing.count) {
+        if (coalescing.count == coalescing.size) {
+            coalescing.size += 8;
+            coalescing.classes = (CoalescingRec *)
+                XtRealloc((char *) coalescing.classes,
+                          (Cardinal) ((size_t) coalescing.size *
+                                      sizeof(CoalescingRec)));
+        }
+        coalescing.classes[coalescing.count++].widget_class = widget_class;
+    }
+    coalescing.classes[i].flags = flags;
+    UNLOCK_PROCESS;
+}
+
+/* Called with the process lock held */
+static int
+MyGetCoalescing(WidgetClass widget_class)
+{
+    int i;
+
+    for (i = 0; i < coalescing.count; i++)
+        if (coalescing.classes[i].widget_class == widget_class)
+            return coalescing.classes[i].flags;
+    return 0;
+}
+
+/*
+ * The MotionNotify events of the last recorded run on each display.  A run
+ * only replaces the history of its own display, so an event dispatched from
+ * a nested loop leaves the history alone unless it is itself a recorded
+ * run of motion events.
+ */
+typedef struct _MotionHistoryRec {
+    struct _MotionHistoryRec *next;
+    Display *dpy;
+    XMotionEvent *events;
+    Cardinal count;
+    Cardinal size;
+} MotionHistoryRec, *MotionHistory;
+
+static MotionHistory motionHistories = NULL;
+
+/* Called from the destroy callbacks of the display */
+static void
+MyFreeMotionHistory(Widget w, XtPointer closure, XtPointer call_data)
+{
+    MotionHistory history = (MotionHistory) closure;
+    MotionHistory *prev;
+
+    LOCK_PROCESS;
+    for (prev = &motionHistories; *prev != history; prev = &(*prev)->next);
+    *prev = history->next;
+    UNLOCK_PROCESS;
+    XtFree((char *) history->events);
+    XtFree((char *) history);
+}
+
+static MotionHistory
+MyFindMotionHistory(Display *dpy, Boolean create)
+{
+    MotionHistory history;
+
+    LOCK_PROCESS;
+    for (history = motionHistories; history; history = history->next)
+        if (history->dpy == dpy)
+            break;
+    if (history == NULL && create) {
+        history = XtNew(MotionHistoryRec);
+        history->dpy = dpy;
+        history->events = NULL;
+        history->count = history->size = 0;
+        history->next = motionHistories;
+        motionHistories = history;
+        _XtAddCallback(&_XtGetPerDisplay(dpy)->destroy_callbacks,
+                       MyFreeMotionHistory, (XtPointer) history);
+    }
+    UNLOCK_PROCESS;
+    return history;
+}
+
+static void
+MyRecordMotion(MotionHistory history, XEvent *event)
+{
+    if (history->count == history->size) {
+        history->size = history->size ? 2 * history->size : 64;
+        history->events = (XMotionEvent *)
+            XtRealloc((char *) history->events,
+                      (Cardinal) ((size_t) history->size *
+                                  sizeof(XMotionEvent)));
+    }
+    history->events[history->count++] = event->xmotion;
+}
+
+/*
+ * Returns the MotionNotify events of the last run that was coalesced on
+ * dpy for a widget class with MyCoalesceMotionHistory, oldest first and
+ * ending with the event that was dispatched.
+ */
+static XMotionEvent *
+MyXtGetMotionHistory(Display *dpy, Cardinal *num_events)
+{
+    MotionHistory history = MyFindMotionHistory(dpy, False);
+
+    if (history == NULL) {
+        *num_events = 0;
+        return NULL;
+    }
+    *num_events = history->count;
+    return history->events;
+}
+
+/*
+ * Replaces event by the last of the run of queued events that it starts,
+ * if the widget class of its window asked for that type of event to be
+ * coalesced.  Only consecutive events for the same window are merged, so
+ * the relative order of events is preserved.
+ */
+static void
+MyCoalesceEvent(XEvent *event)
+{
+    Display *dpy = event->xany.display;
+    Widget widget;
+    MotionHistory history = NULL;
+    Boolean compress_motion;
+    int flags;
+
+    if (event->type != MotionNotify && event->type != ConfigureNotify)
+        return;
+    widget = XtWindowToWidget(dpy, event->xany.window);
+    if (widget == NULL)
+        return;
+    LOCK_PROCESS;
+    compress_motion = widget->core.widget_class->core_class.compress_motion;
+    flags = MyGetCoalescing(widget->core.widget_class);
+    UNLOCK_PROCESS;
+
+    if (event->type == MotionNotify) {
+        if (!compress_motion)
+            return;
+        if (flags & MyCoalesceMotionHistory) {
+            history = MyFindMotionHistory(dpy, True);
+            history->count = 0;
+            MyRecordMotion(history, event);
+        }
+    }
+    else if (!(flags & MyCoalesceConfigure))
+        return;
+
+    while (XPending(dpy)) {
+        XEvent nextEvent;
+        XPeekEvent(dpy, &nextEvent);
+
+        if (nextEvent.type != event->type ||
+            nextEvent.xany.window != event->xany.window)
+            break;
+        if (event->type == MotionNotify &&
+            nextEvent.xmotion.subwindow != event->xmotion.subwindow)
+            break;
+        if (event->type == ConfigureNotify &&
+            nextEvent.xconfigure.window != event->xconfigure.window)
+            break;
+        /* replace the current event with the next one */
+        XNextEvent(dpy, event);
+        if (history != NULL)
+            MyRecordMotion(history, event);
+    }
+}
+
+#define NonMaskableMask ((EventMask)0x80000000L)
+
+static EventMask const masks[] = {
+    0,                          /* Error, should never see  */
+    0,                          /* Reply, should never see  */
+    KeyPressMask,               /* KeyPress                 */
+    KeyReleaseMask,             /* KeyRelease               */
+    ButtonPressMask,            /* ButtonPress              */
+    ButtonReleaseMask,          /* ButtonRelease            */
+    PointerMotionMask           /* MotionNotify             */
+        | ButtonMotionMask,
+    EnterWindowMask,            /* EnterNotify              */
+    LeaveWindowMask,            /* LeaveNotify              */
+    FocusChangeMask,            /* FocusIn                  */
+    FocusChangeMask,            /* FocusOut                 */
+    KeymapStateMask,            /* KeymapNotify             */
+    ExposureMask,               /* Expose                   */
+    NonMaskableMask,            /* GraphicsExpose, in GC    */
+    NonMaskableMask,            /* NoExpose, in GC          */
+    VisibilityChangeMask,       /* VisibilityNotify         */
+    SubstructureNotifyMask,     /* CreateNotify             */
+    StructureNotifyMask         /* DestroyNotify            */
+        | SubstructureNotifyMask,
+    StructureNotifyMask         /* UnmapNotify              */
+        | SubstructureNotifyMask,
+    StructureNotifyMask         /* MapNotify                */
+        | SubstructureNotifyMask,
+    SubstructureRedirectMask,   /* MapRequest               */
+    StructureNotifyMask         /* ReparentNotify           */
+        | SubstructureNotifyMask,
+    StructureNotifyMask         /* ConfigureNotify          */
+        | SubstructureNotifyMask,
+    SubstructureRedirectMask,   /* ConfigureRequest         */
+    StructureNotifyMask         /* GravityNotify            */
+        | SubstructureNotifyMask,
+    ResizeRedirectMask,         /* ResizeRequest            */
+    StructureNotifyMask         /* CirculateNotify          */
+        | SubstructureNotifyMask,
+    SubstructureRedirectMask,   /* CirculateRequest         */
+    PropertyChangeMask,         /* PropertyNotify           */
+    NonMaskableMask,            /* SelectionClear           */
+    NonMaskableMask,            /* SelectionRequest         */
+    NonMaskableMask,            /* SelectionNotify          */
+    ColormapChangeMask,         /* ColormapNotify           */
+    NonMaskableMask,            /* ClientMessage            */
+    NonMaskableMask             /* MappingNotify            */
+};
+
+static EventMask
+_MyXtConvertTypeToMask(int eventType)
+{
+    if ((Cardinal) eventType < XtNumber(masks))
+        return masks[eventType];
+    else
+        return NoEventMask;
+}
+static Widget
+_MyXtFindRemapWidget(XEvent *event,
                    Widget widget,
                    EventMask mask,
                    XtPerDisplayInput pdi)
@@ -1745,12 +2225,10 @@ typedef struct _TMBindCacheStatusRec {
 } TMBindCacheStatusRec, *TMBindCacheStatus;
 
 typedef struct _TMBindCacheRec {
-    struct _TMBindCacheRec *next;
+    struct _TMBindCacheRec *next;       /* must remain first */
     TMBindCacheStatusRec status;
     TMStateTree stateTree;
-#ifdef TRACE_TM
     WidgetClass widgetClass;
-#endif                          /* TRACE_TM */
     XtActionProc procs[1];      /* variable length */
 } TMBindCacheRec, *TMBindCache;
 
@@ -1818,12 +2296,15 @@ MyIsDescendant(Widget widget, Widget root)
     return True;
 }
 
+extern Boolean _XtArenaRelease(Widget);
+
 static void
 MyPhase2Destroy(register Widget widget)
 {
     register WidgetClass class;
     register ConstraintWidgetClass cwClass;
     ObjectClassExtension ext;
+    Boolean in_arena;
 
     /* Call constraint destroy procedures */
     if (XtParent(widget) != NULL && !XtIsShell(widget) &&
@@ -1861,6 +2342,7 @@ MyPhase2Destroy(register Widget widget)
     }
 
     /* Call widget deallocate procedure */
+    in_arena = _XtArenaRelease(widget);
     ext = (ObjectClassExtension) XtGetClassExtension(widget->core.widget_class,
                                                      XtOffsetOf(CoreClassPart,
                                                                 extension),
@@ -1877,12 +2359,30 @@ MyPhase2Destroy(register Widget widget)
     }
     else {
         UNLOCK_PROCESS;
-        XtFree((char *) widget);
+        if (!in_arena)
+            XtFree((char *) widget);
     }
 }                               /* Phase2Destroy */
 
+static Boolean
+MyIsPopup(Widget widget, Widget parent)
+{
+    Cardinal i;
+
+    if (parent && XtIsWidget(parent)) {
+        for (i = 0; i < parent->core.num_popups; i++) {
+            if (parent->core.popup_list[i] == widget)
+                return True;
+        }
+    }
+    return False;
+}
+
+extern void _XtIndexChildDeleted(Widget);
+extern void _XtInvalidateNameCache(void);
+
 static void
-MyXtPhase2Destroy(Widget widget)
+MyXtPhase2Destroy(Widget widget, Boolean detached)
 {
     Display *display = NULL;
     Window window;
@@ -1896,19 +2396,13 @@ MyXtPhase2Destroy(Widget widget)
     _XtGetPerDisplay(XtDisplayOfObject(widget))->pdi.traceDepth = 0;
 
     parent = widget->core.parent;
+    if (!detached)
+        _XtIndexChildDeleted(widget);
 
-    if (parent && XtIsWidget(parent) && parent->core.num_popups) {
-        Cardinal i;
-
-        for (i = 0; i < parent->core.num_popups; i++) {
-            if (parent->core.popup_list[i] == widget) {
-                isPopup = True;
-                break;
-            }
-        }
-    }
+    if (parent && parent->core.num_popups)
+        isPopup = MyIsPopup(widget, parent);
 
-    if (!isPopup && parent && XtIsComposite(parent)) {
+    if (!detached && !isPopup && parent && XtIsComposite(parent)) {
         XtWidgetProc delete_child;
 
         LOCK_PROCESS;
@@ -1958,23 +2452,20 @@ MyXtPhase2Destroy(Widget widget)
 
             DestroyRec *dr = app->destroy_list + i;
 
-            if (MyIsDescendant(dr->widget, widget)) {
+            if (dr->widget && MyIsDescendant(dr->widget, widget)) {
                 Widget descendant = dr->widget;
-                register int j;
 
-                app->destroy_count--;
-                for (j = app->destroy_count - i; --j >= 0; dr++)
-                    *dr = *(dr + 1);
-                MyXtPhase2Destroy(descendant);
+                dr->widget = NULL;
+                MyXtPhase2Destroy(descendant, False);
             }
-            else
-                i++;
+            i++;
         }
     }
 
     app->in_phase2_destroy = widget;
     MyRecursive(widget, MyPhase2Destroy);
     app->in_phase2_destroy = outerInPhase2Destroy;
+    _XtInvalidateNameCache();
 
     if (isPopup) {
         Cardinal i;
@@ -1999,6 +2490,35 @@ MyXtPhase2Destroy(Widget widget)
 }
 
 
+static Cardinal
+MyCollectSiblings(XtAppContext app, int i, int dispatch_level, WidgetList list)
+{
+    Widget parent = app->destroy_list[i].widget->core.parent;
+    Cardinal n = 0;
+
+    if (parent == NULL || !XtIsComposite(parent))
+        return 0;
+    for (; i < app->destroy_count; i++) {
+        DestroyRec *dr = app->destroy_list + i;
+
+        if (dr->widget == NULL || dr->dispatch_level < dispatch_level)
+            continue;
+        if (dr->widget->core.parent != parent ||
+            (parent->core.num_popups && MyIsPopup(dr->widget, parent)))
+            break;
+        if (list) {
+            list[n] = dr->widget;
+            dr->widget = NULL;
+        }
+        n++;
+    }
+    return n;
+}
+
+extern void _XtEnterDestroyList(XtAppContext);
+extern void _XtLeaveDestroyList(XtAppContext);
+extern void _XtDeleteChildren(Widget, WidgetList, Cardinal);
+
 static void
 _MyXtDoPhase2Destroy(XtAppContext app, int dispatch_level)
 {
@@ -2008,6 +2528,7 @@ _MyXtDoPhase2Destroy(XtAppContext app, int dispatch_level)
 
     int i = 0;
 
+    _XtEnterDestroyList(app);
     while (i < app->destroy_count) {
 
         /* XtPhase2Destroy can result in calls to XtDestroyWidget,
@@ -2016,18 +2537,30 @@ _MyXtDoPhase2Destroy(XtAppContext app, int dispatch_level)
 
         DestroyRec *dr = app->destroy_list + i;
 
-        if (dr->dispatch_level >= dispatch_level) {
+        if (dr->widget && dr->dispatch_level >= dispatch_level) {
             Widget w = dr->widget;
-            register int j;
-
-            app->destroy_count--;
-            for (j = app->destroy_count - i; --j >= 0; dr++)
-                *dr = *(dr + 1);
-            MyXtPhase2Destroy(w);
+            Cardinal n = MyCollectSiblings(app, i, dispatch_level, NULL);
+
+            if (n > 1) {
+                Widget cache[64];
+                WidgetList siblings = (WidgetList)
+                    XtStackAlloc(n * sizeof(Widget), cache);
+                Cardinal k;
+
+                MyCollectSiblings(app, i, dispatch_level, siblings);
+                _XtDeleteChildren(w->core.parent, siblings, n);
+                for (k = 0; k < n; k++)
+                    MyXtPhase2Destroy(siblings[k], True);
+                XtStackFree((XtPointer) siblings, cache);
+            }
+            else {
+                dr->widget = NULL;
+                MyXtPhase2Destroy(w, False);
+            }
         }
-        else
-            i++;
+        i++;
     }
+    _XtLeaveDestroyList(app);
 }
 
 static Boolean
@@ -2045,6 +2578,8 @@ MyXtDispatchEvent(XEvent *event)
     dispatch_level = ++app->dispatch_level;
     starting_count = app->destroy_count;
 
+    MyCoalesceEvent(event);
+
     switch (event->type) {
     case KeyPress:
     case KeyRelease:
@@ -2110,84 +2645,554 @@ MyXtDispatchEvent(XEvent *event)
     return was_dispatched;
 }
 
+static void
+MyQueueWorkProc(PriorityWorkProcRec *w)
+{
+    PriorityWorkProcRec **pp = &work.first;
+
+    while (*pp != NULL && (*pp)->priority >= w->priority)
+        pp = (PriorityWorkProcRec **) &(*pp)->wp.next;
+    w->wp.next = (WorkProcRec *) *pp;
+    *pp = w;
+}
+
+static XtWorkProcId
+MyXtAppAddWorkProc(XtAppContext app, XtWorkProc proc, XtPointer closure,
+                   int priority)
+{
+    PriorityWorkProcRec *w = (PriorityWorkProcRec *) MyPoolAlloc(WORK_POOL);
+
+    LOCK_APP(app);
+    w->wp.proc = proc;
+    w->wp.closure = closure;
+    w->wp.app = app;
+    w->priority = priority;
+    MyQueueWorkProc(w);
+    UNLOCK_APP(app);
+    return (XtWorkProcId) w;
+}
+
+static void
+MyXtRemoveWorkProc(XtWorkProcId id)
+{
+    PriorityWorkProcRec *w = (PriorityWorkProcRec *) id;
+    PriorityWorkProcRec **pp;
+    XtAppContext app = w->wp.app;
+
+    LOCK_APP(app);
+    if (w == work.running) {
+        work.running_removed = True;
+        UNLOCK_APP(app);
+        return;
+    }
+    for (pp = &work.first; *pp != NULL;
+         pp = (PriorityWorkProcRec **) &(*pp)->wp.next) {
+        if (*pp == w) {
+            *pp = (PriorityWorkProcRec *) w->wp.next;
+            MyPoolFree(WORK_POOL, w);
+            break;
+        }
+    }
+    UNLOCK_APP(app);
+}
+
 static Boolean
 MyCallWorkProc(XtAppContext app)
 {
     register WorkProcRec *w = app->workQueue;
+    PriorityWorkProcRec *pw = work.first;
     Boolean delete;
 
+    if (pw != NULL && (w == NULL || pw->priority > 0 ||
+                       (pw->priority == 0 && !work.stock_turn))) {
+        /* Run ours, then let the others of equal priority have a turn */
+        if (pw->priority == 0)
+            work.stock_turn = True;
+        work.first = (PriorityWorkProcRec *) pw->wp.next;
+        work.running = pw;
+        work.running_removed = False;
+        delete = (*(pw->wp.proc)) (pw->wp.closure);
+        work.running = NULL;
+        if (delete || work.running_removed)
+            MyPoolFree(WORK_POOL, pw);
+        else
+            MyQueueWorkProc(pw);
+        work.calls++;
+        return TRUE;
+    }
+
     if (w == NULL)
         return FALSE;
 
+    work.stock_turn = False;
     app->workQueue = w->next;
 
     delete = (*(w->proc)) (w->closure);
+    work.calls++;
 
+    w->next = app->workQueue;
+    app->workQueue = w;
     if (delete) {
-#ifdef XTHREADS
-        if(_XtProcessLock)(*_XtProcessLock)();
-#endif
-        w->next = freeWorkRecs;
-        freeWorkRecs = w;
-#ifdef XTHREADS
-        if(_XtProcessUnlock)(*_XtProcessUnlock)();
-#endif
-    }
-    else {
-        w->next = app->workQueue;
-        app->workQueue = w;
+        /* Found at the head, so that Xt recycles the record */
+        XtRemoveWorkProc((XtWorkProcId) w);
     }
     return TRUE;
 }
 
-
-static void
-MyXtAppProcessEvent(XtAppContext app)
+/* Returns True if there is input that should preempt the work procedures. */
+static Boolean
+MyInputPending(XtAppContext app)
 {
-    int i, d;
-    XEvent event;
     struct timeval cur_time;
+    TimerEventRec *te_ptr;
+    Boolean in_heap;
+    int d;
 
+    for (d = 0; d < app->count; d++)
+        if (XEventsQueued(app->list[d], QueuedAfterReading))
+            return TRUE;
+    if (app->signalQueue != NULL)
+        return TRUE;
+    if ((te_ptr = MyNextTimer(app, &in_heap)) != NULL) {
+        X_GETTIMEOFDAY(&cur_time);
+        FIXUP_TIMEVAL(cur_time);
+        if (IS_AT_OR_AFTER(te_ptr->te_timer_value, cur_time))
+            return TRUE;
+    }
+    if (app->input_count > 0 && app->outstandingQueue == NULL)
+        _MyXtWaitForSomething1(app);
+    return app->outstandingQueue != NULL;
+}
 
-#ifdef XTHREADS
-    if(app && app->lock)(*app->lock)(app);
-#endif
+/*
+ * Calls work procedures until none are left, the time slice has passed, or
+ * input arrives.  Returns False if there was no work procedure to call.
+ */
+static Boolean
+MyRunWorkProcs(XtAppContext app)
+{
+    struct timeval start_time, deadline, cur_time, spent;
 
-    for (;;) {
+    if (work.first == NULL && app->workQueue == NULL)
+        return FALSE;
 
-        if (app->signalQueue != NULL) {
-            SignalEventRec *se_ptr = app->signalQueue;
+    X_GETTIMEOFDAY(&start_time);
+    FIXUP_TIMEVAL(start_time);
+    ADD_TIME(deadline, start_time, work.slice);
+    work.slices++;
+    while (MyCallWorkProc(app)) {
+        X_GETTIMEOFDAY(&cur_time);
+        FIXUP_TIMEVAL(cur_time);
+        if (IS_AT_OR_AFTER(deadline, cur_time))
+            break;
+        if (MyInputPending(app)) {
+            work.preempted++;
+            break;
+        }
+    }
+    X_GETTIMEOFDAY(&cur_time);
+    FIXUP_TIMEVAL(cur_time);
+    TIMEDELTA(spent, cur_time, start_time);
+    ADD_TIME(work.work_time, work.work_time, spent);
+    return TRUE;
+}
 
-            while (se_ptr != NULL) {
-                if (se_ptr->se_notice) {
-                    se_ptr->se_notice = FALSE;
-                    SeCallProc(se_ptr);
-#ifdef XTHREADS
-                    if(app && app->unlock)(*app->unlock)(app);
-#endif
-                    return;
-                }
-                se_ptr = se_ptr->se_next;
+/* Returns True if event may be merged into the damage of its window. */
+static Boolean
+MyCanBucketExposure(XEvent *event)
+{
+    Widget widget;
+    Boolean result;
+
+    if (event->type != Expose && event->type != GraphicsExpose)
+        return False;
+    widget = XtWindowToWidget(event->xany.display, event->xany.window);
+    if (widget == NULL)
+        return False;
+    LOCK_PROCESS;
+    result = (widget->core.widget_class->core_class.expose != NULL &&
+              COMP_EXPOSE_TYPE == XtExposeCompressMaximal &&
+              (event->type == Expose || GRAPHICS_EXPOSE));
+    UNLOCK_PROCESS;
+    return result;
+}
+
+static void
+MyAddToExposeBucket(XEvent *event)
+{
+    Display *dpy = event->xany.display;
+    ExposeBucket *bucket;
+    XPointer data;
+    int i = ExposeIndex(event);
+
+    if (XFindContext(dpy, event->xany.window, exposures.context, &data) == 0)
+        bucket = &exposures.buckets[(intptr_t) data - 1];
+    else {
+        if (exposures.count == exposures.size) {
+            int n = exposures.size ? 2 * exposures.size : 16;
+
+            exposures.buckets = (ExposeBucket *)
+                XtRealloc((char *) exposures.buckets,
+                          (Cardinal) ((size_t) n * sizeof(ExposeBucket)));
+            for (; exposures.size < n; exposures.size++) {
+                bucket = &exposures.buckets[exposures.size];
+                bucket->region[0] = XCreateRegion();
+                bucket->region[1] = XCreateRegion();
             }
         }
+        bucket = &exposures.buckets[exposures.count++];
+        bucket->dpy = dpy;
+        bucket->window = event->xany.window;
+        bucket->pending[0] = bucket->pending[1] = False;
+        XSaveContext(dpy, bucket->window, exposures.context,
+                     (XPointer) (intptr_t) exposures.count);
+    }
+    if (!bucket->pending[i]) {
+        bucket->pending[i] = True;
+        bucket->event[i] = *event;
+    }
+    bucket->count[i] = GetCount(event);
+    XtAddExposureToRegion(event, bucket->region[i]);
+}
 
-        if (app->timerQueue != NULL) {
+/*
+ * Called with an exposure event that was just read.  If exposures for
+ * compressing widgets are queued directly behind it, moves the whole run
+ * into their windows' buckets and returns True.  Exposures after any other
+ * event stay queued, and a series that is not complete within the run is
+ * finished by MyCompressExposures.
+ */
+static Boolean
+MyCollectExposures(XEvent *event)
+{
+    Display *dpy = event->xany.display;
+    XEvent next;
+
+    if (exposures.active || !MyCanBucketExposure(event))
+        return False;
+    if (XEventsQueued(dpy, QueuedAfterReading) == 0)
+        return False;
+    XPeekEvent(dpy, &next);
+    if (!MyCanBucketExposure(&next))
+        return False;
+
+    if (exposures.context == 0)
+        exposures.context = XUniqueContext();
+    MyAddToExposeBucket(event);
+    do {
+        XNextEvent(dpy, &next);
+        MyAddToExposeBucket(&next);
+        if (XEventsQueued(dpy, QueuedAlready) == 0)
+            break;
+        XPeekEvent(dpy, &next);
+    } while (MyCanBucketExposure(&next));
+    return True;
+}
+
+/*
+ * Dispatches one event per bucket; MyCompressExposures then picks up the
+ * accumulated damage through MyTakeExposeBucket.
+ */
+static void
+MyDispatchExposures(void)
+{
+    int i, j;
+
+    exposures.active = TRUE;
+    for (i = 0; i < exposures.count; i++) {
+        ExposeBucket *bucket = &exposures.buckets[i];
+
+        for (j = 0; j < 2; j++) {
+            if (bucket->pending[j]) {
+                XEvent event = bucket->event[j];
+
+                MyXtDispatchEvent(&event);
+            }
+        }
+    }
+    for (i = 0; i < exposures.count; i++) {
+        ExposeBucket *bucket = &exposures.buckets[i];
+
+        XDeleteContext(bucket->dpy, bucket->window, exposures.context);
+        for (j = 0; j < 2; j++)
+            (void) XIntersectRegion(nullRegion, bucket->region[j],
+                                    bucket->region[j]);
+    }
+    exposures.count = 0;
+    exposures.active = FALSE;
+}
+
+/*
+ * Each display gets a budget of events to dispatch every time the loop
+ * finds X events, so that a busy display cannot starve the others.  The
+ * latency of a display is the time between the loop first seeing events
+ * queued for it and the start of the batch that dispatches them.  Events
+ * that were already waiting when the loop first sees them are dated by
+ * their server timestamp, mapped to the local clock through the smallest
+ * difference between the two clocks seen so far on the display.
+ */
+
+#define DEFAULT_EVENT_BUDGET 16
+
+typedef struct {
+    Display *dpy;
+    int budget;                 /* Events dispatched per batch */
+    unsigned long events;       /* Events dispatched */
+    unsigned long batches;      /* Times the display was serviced */
+    unsigned long exhausted;    /* Batches that left events queued */
+    struct timeval ready;       /* Events waiting since, or zero */
+    struct timeval max_latency;
+    struct timeval total_latency;
+    Boolean clock_known;
+    CARD32 clock_offset;        /* Local minus server time, in ms */
+} DisplaySchedule;
+
+static struct {
+    DisplaySchedule *displays;
+    int count;
+    int size;
+    int budget;                 /* Budget given to new displays */
+} schedule = {NULL, 0, 0, DEFAULT_EVENT_BUDGET};
+
+/* Called from the destroy callbacks of the display */
+static void
+MyFreeDisplaySchedule(Widget w, XtPointer closure, XtPointer call_data)
+{
+    Display *dpy = (Display *) closure;
+    int i;
+
+    for (i = 0; i < schedule.count; i++) {
+        if (schedule.displays[i].dpy == dpy) {
+            schedule.displays[i] = schedule.displays[--schedule.count];
+            break;
+        }
+    }
+}
+
+static DisplaySchedule *
+MyFindDisplaySchedule(Display *dpy, Boolean create)
+{
+    DisplaySchedule *ds;
+    int i;
+
+    for (i = 0; i < schedule.count; i++)
+        if (schedule.displays[i].dpy == dpy)
+            return &schedule.displays[i];
+    if (!create)
+        return NULL;
+    if (schedule.count == schedule.size) {
+        schedule.size += 4;
+        schedule.displays = (DisplaySchedule *)
+            XtRealloc((char *) schedule.displays,
+                      (Cardinal) ((size_t) schedule.size *
+                                  sizeof(DisplaySchedule)));
+    }
+    ds = &schedule.displays[schedule.count++];
+    memset(ds, 0, sizeof(DisplaySchedule));
+    ds->dpy = dpy;
+    ds->budget = schedule.budget;
+    _XtAddCallback(&_XtGetPerDisplay(dpy)->destroy_callbacks,
+                   MyFreeDisplaySchedule, (XtPointer) dpy);
+    return ds;
+}
+
+/* Returns the server timestamp of event, or CurrentTime if it has none */
+static Time
+MyEventTime(XEvent *event)
+{
+    switch (event->type) {
+    case KeyPress:
+    case KeyRelease:
+        return event->xkey.time;
+    case ButtonPress:
+    case ButtonRelease:
+        return event->xbutton.time;
+    case MotionNotify:
+        return event->xmotion.time;
+    case EnterNotify:
+    case LeaveNotify:
+        return event->xcrossing.time;
+    case PropertyNotify:
+        return event->xproperty.time;
+    case SelectionClear:
+        return event->xselectionclear.time;
+    case SelectionRequest:
+        return event->xselectionrequest.time;
+    case SelectionNotify:
+        return event->xselection.time;
+    default:
+        return CurrentTime;
+    }
+}
+
+/*
+ * Sets ds->ready to the local time at which the first event queued on the
+ * display was sent, as far as its server timestamp tells, or to now.
+ */
+static void
+MySeedReadyTime(DisplaySchedule *ds, struct timeval *now)
+{
+    XEvent event;
+    Time time;
+    CARD32 offset, late;
+
+    ds->ready = *now;
+    XPeekEvent(ds->dpy, &event);
+    time = MyEventTime(&event);
+    if (time == CurrentTime)
+        return;
+    offset = (CARD32) ((unsigned long) now->tv_sec * 1000 +
+                       (unsigned long) now->tv_usec / 1000 - time);
+    if (!ds->clock_known || (INT32) (offset - ds->clock_offset) < 0) {
+        ds->clock_offset = offset;
+        ds->clock_known = TRUE;
+    }
+    late = offset - ds->clock_offset;
+    ds->ready.tv_sec -= (time_t) (late / 1000);
+    ds->ready.tv_usec -= (suseconds_t) ((late % 1000) * 1000);
+    if (ds->ready.tv_usec < 0) {
+        ds->ready.tv_sec--;
+        ds->ready.tv_usec += 1000000;
+    }
+}
+
+static void
+MyProcessXEvent(Display *dpy)
+{
+    XEvent event;
+
+    XNextEvent(dpy, &event);
+    if (event.xany.type == MappingNotify) {
+        _MyXtRefreshMapping(&event);
+    }
+    if (dpy == notifier.sharedDisplay &&
+        XtWindowToWidget(dpy, event.xany.window) == NULL) {
+        /*
+         * Everything that is not for an Xt widget, including MappingNotify
+         * and root window events, goes through Tk's event queue, in order.
+         */
+        Tk_QueueWindowEvent(&event, TCL_QUEUE_TAIL);
+        Tcl_ServiceAll();
+    }
+    else if (MyCollectExposures(&event))
+        MyDispatchExposures();
+    else
+        MyXtDispatchEvent(&event);
+}
+
+/*
+ * Dispatches a batch of events from every display that has events queued,
+ * in round-robin order starting with display first.
+ */
+static void
+MyDispatchDisplays(XtAppContext app, int first)
+{
+    struct timeval start_time, cur_time, latency;
+    int i, d, n, budget, count = app->count;
+
+    X_GETTIMEOFDAY(&start_time);
+    FIXUP_TIMEVAL(start_time);
+    for (i = 0; i < count; i++) {
+        Display *dpy;
+        DisplaySchedule *ds;
+
+        d = (first + i) % count;
+        if (d >= app->count)    /* a display was closed while dispatching */
+            break;
+        dpy = app->list[d];
+        ds = MyFindDisplaySchedule(dpy, True);
+        if (!XEventsQueued(dpy, QueuedAfterReading)) {
+            ds->ready = zero_time;
+            continue;
+        }
+        if (!timerisset(&ds->ready))
+            MySeedReadyTime(ds, &start_time);
+        X_GETTIMEOFDAY(&cur_time);
+        FIXUP_TIMEVAL(cur_time);
+        TIMEDELTA(latency, cur_time, ds->ready);
+        if (IS_AFTER(ds->max_latency, latency))
+            ds->max_latency = latency;
+        ADD_TIME(ds->total_latency, ds->total_latency, latency);
+
+        budget = ds->budget;
+        for (n = 0; n < budget; n++) {
+            MyProcessXEvent(dpy);
+            if (d >= app->count || app->list[d] != dpy ||
+                !XEventsQueued(dpy, QueuedAlready))
+                break;
+        }
+        if (d >= app->count || app->list[d] != dpy)
+            break;
+        /* Closing other displays while dispatching may have moved it */
+        ds = MyFindDisplaySchedule(dpy, True);
+        ds->events += (unsigned long) (n < budget ? n + 1 : n);
+        ds->batches++;
+        app->last = (short) d;
+        if (XEventsQueued(dpy, QueuedAlready)) {
+            ds->exhausted++;
+            X_GETTIMEOFDAY(&ds->ready);
+            FIXUP_TIMEVAL(ds->ready);
+        }
+        else
+            ds->ready = zero_time;
+    }
+}
+
+static void
+MyXtAppProcessEvent(XtAppContext app)
+{
+    int i, d;
+    struct timeval cur_time;
+    TimerEventRec *te_ptr;
+    Boolean in_heap;
+
+#ifdef XTHREADS
+    if(app && app->lock)(*app->lock)(app);
+#endif
+
+    for (;;) {
+
+        if (app->signalQueue != NULL) {
+            SignalEventRec *se_ptr = app->signalQueue;
+
+            while (se_ptr != NULL) {
+                if (se_ptr->se_notice) {
+                    se_ptr->se_notice = FALSE;
+                    SeCallProc(se_ptr);
+#ifdef XTHREADS
+                    if(app && app->unlock)(*app->unlock)(app);
+#endif
+                    return;
+                }
+                se_ptr = se_ptr->se_next;
+            }
+        }
+
+        if ((te_ptr = MyNextTimer(app, &in_heap)) != NULL) {
             X_GETTIMEOFDAY(&cur_time);
             FIXUP_TIMEVAL(cur_time);
-            if (IS_AT_OR_AFTER(app->timerQueue->te_timer_value, cur_time)) {
-                TimerEventRec *te_ptr = app->timerQueue;
+            if (IS_AT_OR_AFTER(te_ptr->te_timer_value, cur_time)) {
+                Boolean rearmable = FALSE;
 
-                app->timerQueue = app->timerQueue->te_next;
+                if (in_heap) {
+                    rearmable = ((HeapTimerRec *) te_ptr)->rearmable;
+                    MyDequeueTimerEvent((HeapTimerRec *) te_ptr);
+                }
+                else
+                    app->timerQueue = te_ptr->te_next;
                 te_ptr->te_next = NULL;
                 if (te_ptr->te_proc != NULL)
                     TeCallProc(te_ptr);
+                /* A re-armable record may already be pending again. */
+                if (!in_heap) {
+                    /* Put it back at the head so that Xt can recycle it */
+                    te_ptr->te_next = app->timerQueue;
+                    app->timerQueue = te_ptr;
+                    XtRemoveTimeOut((XtIntervalId) te_ptr);
+                }
+                else if (!rearmable)
+                    MyPoolFree(TIMER_POOL, te_ptr);
 #ifdef XTHREADS
-                if(_XtProcessLock)(*_XtProcessLock)();
-#endif
-                te_ptr->te_next = freeTimerRecs;
-                freeTimerRecs = te_ptr;
-#ifdef XTHREADS
-                if(_XtProcessUnlock)(*_XtProcessUnlock)();
                 if(app && app->unlock)(*app->unlock)(app);
 #endif
                 return;
@@ -2223,18 +3228,13 @@ MyXtAppProcessEvent(XtAppContext app)
 
         /* Nothing to do...wait for something */
 
-        if (MyCallWorkProc(app))
+        if (MyRunWorkProcs(app))
             continue;
 
         d = _MyXtWaitForSomething2(app);
         if (d != -1) {
  GotEvent:
-            XNextEvent(app->list[d], &event);
-            app->last = (short) d;
-            if (event.xany.type == MappingNotify) {
-                _MyXtRefreshMapping(&event);
-            }
-            MyXtDispatchEvent(&event);
+            MyDispatchDisplays(app, d);
 #ifdef XTHREADS
             if(app && app->unlock)(*app->unlock)(app);
 #endif
@@ -2275,14 +3275,14 @@ static void
 SetTimer(const Tcl_Time *timePtr)
 {
     unsigned long timeout;
-    if (notifier.currentTimeout != 0) {
-	MyXtRemoveTimeOut(notifier.currentTimeout);
-    }
     if (timePtr) {
 	timeout = timePtr->sec * 1000 + timePtr->usec / 1000;
-	notifier.currentTimeout = MyXtAppAddTimeOut(notifier.appContext,
-		timeout, TimerProc, NULL);
+	notifier.currentTimeout = MyXtAppRearmTimeOut(notifier.appContext,
+		&notifier.timer, timeout, TimerProc, NULL);
     } else {
+	if (notifier.currentTimeout != 0) {
+	    MyXtRemoveTimeOut(notifier.currentTimeout);
+	}
 	notifier.currentTimeout = 0;
     }
 }
@@ -2292,6 +3292,8 @@ static XtInputMask MyXtAppPending(XtAppContext app)
     struct timeval cur_time;
     int d;
     XtInputMask ret = 0;
+    TimerEventRec *te_ptr;
+    Boolean in_heap;
 
 /*
  * Check for pending X events
@@ -2327,11 +3329,11 @@ static XtInputMask MyXtAppPending(XtAppContext app)
 /*
  * Check for pending alternate input
  */
-    if (app->timerQueue != NULL) {      /* check timeout queue */
+    if ((te_ptr = MyNextTimer(app, &in_heap)) != NULL) { /* check timeout queue */
         X_GETTIMEOFDAY(&cur_time);
         FIXUP_TIMEVAL(cur_time);
-        if ((IS_AT_OR_AFTER(app->timerQueue->te_timer_value, cur_time)) &&
-            (app->timerQueue->te_proc != NULL)) {
+        if ((IS_AT_OR_AFTER(te_ptr->te_timer_value, cur_time)) &&
+            (te_ptr->te_proc != NULL)) {
             ret |= XtIMTimer;
         }
     }
@@ -2512,13 +3514,13 @@ DeleteFileHandler(
 	prevPtr->nextPtr = filePtr->nextPtr;
     }
     if (filePtr->mask & TCL_READABLE) {
-	XtRemoveInput(filePtr->read);
+	MyXtRemoveInput(filePtr->read);
     }
     if (filePtr->mask & TCL_WRITABLE) {
-	XtRemoveInput(filePtr->write);
+	MyXtRemoveInput(filePtr->write);
     }
     if (filePtr->mask & TCL_EXCEPTION) {
-	XtRemoveInput(filePtr->except);
+	MyXtRemoveInput(filePtr->except);
     }
     Tcl_Free((char*) filePtr);
 }
@@ -2532,7 +3534,11 @@ NotifierExitHandler(void *unused)
     for (; notifier.firstFileHandlerPtr != NULL; ) {
 	Tcl_DeleteFileHandler(notifier.firstFileHandlerPtr->fd);
     }
-    if (notifier.appContext) {
+    /*
+     * Destroying the application context would close Tk's display, which
+     * Tk closes itself.
+     */
+    if (notifier.appContext && !notifier.sharedDisplay) {
 	XtDestroyApplicationContext(notifier.appContext);
 	notifier.appContext = NULL;
     }
@@ -2662,7 +3668,7 @@ CreateFileHandler(
 	}
     } else {
 	if (filePtr->mask & TCL_READABLE) {
-	    XtRemoveInput(filePtr->read);
+	    MyXtRemoveInput(filePtr->read);
 	}
     }
     if (mask & TCL_WRITABLE) {
@@ -2672,7 +3678,7 @@ CreateFileHandler(
 	}
     } else {
 	if (filePtr->mask & TCL_WRITABLE) {
-	    XtRemoveInput(filePtr->write);
+	    MyXtRemoveInput(filePtr->write);
 	}
     }
     if (mask & TCL_EXCEPTION) {
@@ -2682,7 +3688,7 @@ CreateFileHandler(
 	}
     } else {
 	if (filePtr->mask & TCL_EXCEPTION) {
-	    XtRemoveInput(filePtr->except);
+	    MyXtRemoveInput(filePtr->except);
 	}
     }
     filePtr->mask = mask;
@@ -2718,12 +3724,18 @@ start(PyObject* unused, PyObject* args)
     framePtr = &done;
     done = 0;
 
-    if (threaded) {
+    /* The Python thread state is released while each event is waited for
+     * and dispatched (see ENTER_TCL), so that other Python threads can run
+     * meanwhile, and pending signals are checked between events. */
+    while (!done) {
         ENTER_TCL
-        while (!done) {
-            MyXtAppProcessEvent(notifier.appContext);
-        }
+        MyXtAppProcessEvent(notifier.appContext);
         LEAVE_TCL
+        if (PyErr_CheckSignals() != 0) {
+            (void) Tcl_SetServiceMode(oldMode);
+            framePtr = oldFramePtr;
+            return NULL;
+        }
     }
     (void) Tcl_SetServiceMode(oldMode);
     framePtr = oldFramePtr;
@@ -2731,74 +3743,1094 @@ start(PyObject* unused, PyObject* args)
     return Py_None;
 }
 
-/* Callback to handle mouse clicks */
-static void button_callback1(Widget w, XtPointer client_data, XEvent *event, Boolean *cont) {
-    if (event->type == ButtonPress) {
-        printf("Xt button clicked\n");
-    }
+static PyObject*
+stop(PyObject* unused, PyObject* noargs)
+{
+    if (framePtr) *framePtr = 1;
+    Py_INCREF(Py_None);
+    return Py_None;
 }
 
-static void timer_proc (XtPointer client_data, XtIntervalId *timer)
+/*
+ * Python callbacks registered directly with the Xt notifier.  They are
+ * called from the Xt input, timer and work procedures below, without going
+ * through a Tcl event, Tcl_ServiceAll and _tkinter's command dispatch.
+ */
+
+typedef struct {
+    PyObject_HEAD
+    int fd;
+    int mask;			/* OR'ed combination of TCL_READABLE,
+				 * TCL_WRITABLE, and TCL_EXCEPTION. */
+    XtInputId read;		/* Xt read callback handle. */
+    XtInputId write;		/* Xt write callback handle. */
+    XtInputId except;		/* Xt exception callback handle. */
+    PyObject* callback;
+} InputObject;
+
+typedef struct {
+    PyObject_HEAD
+    XtIntervalId id;
+    PyObject* callback;
+} TimeoutObject;
+
+typedef struct {
+    PyObject_HEAD
+    XtWorkProcId id;
+    PyObject* callback;
+} WorkProcObject;
+
+static PyTypeObject InputType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "events_tcltk.Input",
+    .tp_basicsize = sizeof(InputObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Xt input source",
+};
+
+static PyTypeObject TimeoutType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "events_tcltk.Timeout",
+    .tp_basicsize = sizeof(TimeoutObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Xt timeout",
+};
+
+static PyTypeObject WorkProcType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "events_tcltk.WorkProc",
+    .tp_basicsize = sizeof(WorkProcObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Xt work procedure",
+};
+
+/*
+ * Calls callback with arguments while the event loop is running without
+ * the Python thread state.  Returns the result, or NULL after printing the
+ * exception; the caller must hold the GIL to release the result.
+ */
+static PyObject*
+call_python(PyObject* callback, PyObject* arguments)
 {
-    static int counter = 0;
-    printf("Xt timer update %d\n", counter++);
-    MyXtAppAddTimeOut(notifier.appContext, 1500, timer_proc, NULL);
+    PyObject* result = NULL;
+    PyObject* exception_type;
+    PyObject* exception_value;
+    PyObject* exception_traceback;
+    PyErr_Fetch(&exception_type, &exception_value, &exception_traceback);
+    if (arguments) {
+        result = PyObject_CallObject(callback, arguments);
+        Py_DECREF(arguments);
+    }
+    if (!result) PyErr_Print();
+    PyErr_Restore(exception_type, exception_value, exception_traceback);
+    return result;
 }
 
-static int pipefds[2];
+static void
+remove_input(InputObject* input)
+{
+    if (input->callback == NULL) return;
+    if (input->mask & TCL_READABLE) MyXtRemoveInput(input->read);
+    if (input->mask & TCL_WRITABLE) MyXtRemoveInput(input->write);
+    if (input->mask & TCL_EXCEPTION) MyXtRemoveInput(input->except);
+    input->mask = 0;
+    Py_CLEAR(input->callback);
+    Py_DECREF(input);
+}
 
-static void pipe_proc (XtPointer client_data, int *source, XtInputId *id)
+static void
+input_proc(XtPointer clientData, int *fd, XtInputId *id)
 {
-    char c;
-    int n;
-    printf("Xt file descriptor triggered\n");
-    n = read(pipefds[0], &c, 1);
-    if (n != 1) {
-        fprintf(stderr, "**** FAILED TO READ DATA\n");
-        fflush(stderr);
+    InputObject* input = (InputObject*) clientData;
+    PyGILState_STATE gstate;
+    PyObject* result;
+    int mask = 0;
+
+    if (*id == input->read) mask = TCL_READABLE;
+    else if (*id == input->write) mask = TCL_WRITABLE;
+    else if (*id == input->except) mask = TCL_EXCEPTION;
+
+    gstate = PyGILState_Ensure();
+    Py_INCREF(input);
+    if (input->callback) {
+        result = call_python(input->callback,
+                             Py_BuildValue("(ii)", input->fd, mask));
+        Py_XDECREF(result);
     }
+    Py_DECREF(input);
+    PyGILState_Release(gstate);
 }
 
-static void button_callback2(Widget w, XtPointer client_data, XEvent *event, Boolean *cont) {
-    if (event->type == ButtonPress) {
-        char c = '\n';
-        int n = write(pipefds[1], &c, 1);
-        if (n != 1) {
-            fprintf(stderr, "**** FAILED TO READ DATA\n");
-            fflush(stderr);
+static void
+timeout_proc(XtPointer clientData, XtIntervalId *id)
+{
+    TimeoutObject* timeout = (TimeoutObject*) clientData;
+    PyGILState_STATE gstate;
+    PyObject* result;
+    PyObject* callback;
+
+    gstate = PyGILState_Ensure();
+    timeout->id = 0;
+    callback = timeout->callback;
+    timeout->callback = NULL;
+    result = call_python(callback, PyTuple_New(0));
+    Py_XDECREF(result);
+    Py_DECREF(callback);
+    Py_DECREF(timeout);
+    PyGILState_Release(gstate);
+}
+
+static Boolean
+work_proc(XtPointer clientData)
+{
+    WorkProcObject* work = (WorkProcObject*) clientData;
+    PyGILState_STATE gstate;
+    PyObject* result;
+    Boolean done = True;
+
+    gstate = PyGILState_Ensure();
+    Py_INCREF(work);
+    if (work->callback) {
+        result = call_python(work->callback, PyTuple_New(0));
+        if (result) {
+            done = PyObject_IsTrue(result) != 0;
+            Py_DECREF(result);
         }
     }
+    if (done && work->callback) {
+        /* Xt removes the work procedure when we return True */
+        work->id = 0;
+        Py_CLEAR(work->callback);
+        Py_DECREF(work);
+    }
+    Py_DECREF(work);
+    PyGILState_Release(gstate);
+    return done;
 }
 
-static void button_callback3(Widget w, XtPointer client_data, XEvent *event, Boolean *cont) {
-    if (event->type == ButtonPress) {
-        MyXtAppAddTimeOut(notifier.appContext, 1500, timer_proc, NULL);
+static PyObject*
+add_input(PyObject* unused, PyObject* args)
+{
+    InputObject* input;
+    int fd;
+    int mask;
+    PyObject* callback;
+    if (!PyArg_ParseTuple(args, "iiO", &fd, &mask, &callback)) return NULL;
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "Callback should be callable");
+        return NULL;
+    }
+    if (mask == 0 || mask & ~(TCL_READABLE | TCL_WRITABLE | TCL_EXCEPTION)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "mask should be a combination of READABLE, WRITABLE, and EXCEPTION");
+        return NULL;
     }
+    input = (InputObject*)PyType_GenericNew(&InputType, NULL, NULL);
+    if (!input) return NULL;
+    Py_INCREF(callback);
+    input->callback = callback;
+    input->fd = fd;
+    input->mask = mask;
+    if (mask & TCL_READABLE)
+        input->read = MyXtAppAddInput(notifier.appContext, fd,
+                (void *)(intptr_t)XtInputReadMask, input_proc, input);
+    if (mask & TCL_WRITABLE)
+        input->write = MyXtAppAddInput(notifier.appContext, fd,
+                (void *)(intptr_t)XtInputWriteMask, input_proc, input);
+    if (mask & TCL_EXCEPTION)
+        input->except = MyXtAppAddInput(notifier.appContext, fd,
+                (void *)(intptr_t)XtInputExceptMask, input_proc, input);
+    Py_INCREF(input);
+    return (PyObject*)input;
 }
 
-/* Expose handler to draw the button rectangle + label */
-static void expose_callback(Widget w, XtPointer client_data, XEvent *event, Boolean *cont) {
-    if (event->type == Expose) {
-        Display *dpy = XtDisplay(w);
-        Window win = XtWindow(w);
-        GC gc = XCreateGC(dpy, win, 0, NULL);
-
-        XFontStruct *font = XLoadQueryFont(dpy, "-*-helvetica-bold-r-*-*-48-*-*-*-*-*-*-*");
-        if (font) XSetFont(dpy, gc, font->fid);
-        const char *msg = "Xt";
-        int len = strlen(msg);
-        int dir, asc, desc;
-        XCharStruct overall;
-        XTextExtents(font, msg, len, &dir, &asc, &desc, &overall);
-        int x = (400 - overall.width) / 2;
-	int y = (100 + asc - desc) / 2;
-        XDrawString(dpy, win, gc, x, y, msg, len);
-        XFreeGC(dpy, gc);
-        if (font) XFreeFont(dpy, font);
+static PyObject*
+py_remove_input(PyObject* unused, PyObject* argument)
+{
+    if (!PyObject_TypeCheck(argument, &InputType)) {
+        PyErr_SetString(PyExc_TypeError, "argument is not an input source");
+        return NULL;
     }
+    remove_input((InputObject*)argument);
+    Py_INCREF(Py_None);
+    return Py_None;
 }
 
-/* Expose handler to draw the button rectangle + label */
+static PyObject*
+add_timeout(PyObject* unused, PyObject* args)
+{
+    TimeoutObject* timeout;
+    unsigned long interval;
+    PyObject* callback;
+    if (!PyArg_ParseTuple(args, "kO", &interval, &callback)) return NULL;
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "Callback should be callable");
+        return NULL;
+    }
+    timeout = (TimeoutObject*)PyType_GenericNew(&TimeoutType, NULL, NULL);
+    if (!timeout) return NULL;
+    Py_INCREF(callback);
+    timeout->callback = callback;
+    timeout->id = MyXtAppAddTimeOut(notifier.appContext, interval,
+                                    timeout_proc, timeout);
+    Py_INCREF(timeout);
+    return (PyObject*)timeout;
+}
+
+static PyObject*
+remove_timeout(PyObject* unused, PyObject* argument)
+{
+    TimeoutObject* timeout;
+    if (!PyObject_TypeCheck(argument, &TimeoutType)) {
+        PyErr_SetString(PyExc_TypeError, "argument is not a timeout");
+        return NULL;
+    }
+    timeout = (TimeoutObject*)argument;
+    if (timeout->callback) {
+        MyXtRemoveTimeOut(timeout->id);
+        timeout->id = 0;
+        Py_CLEAR(timeout->callback);
+        Py_DECREF(timeout);
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+add_work_proc(PyObject* unused, PyObject* args)
+{
+    WorkProcObject* work;
+    PyObject* callback;
+    int priority = 0;
+    if (!PyArg_ParseTuple(args, "O|i", &callback, &priority)) return NULL;
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "Callback should be callable");
+        return NULL;
+    }
+    work = (WorkProcObject*)PyType_GenericNew(&WorkProcType, NULL, NULL);
+    if (!work) return NULL;
+    Py_INCREF(callback);
+    work->callback = callback;
+    work->id = MyXtAppAddWorkProc(notifier.appContext, work_proc, work,
+                                  priority);
+    Py_INCREF(work);
+    return (PyObject*)work;
+}
+
+static PyObject*
+remove_work_proc(PyObject* unused, PyObject* argument)
+{
+    WorkProcObject* work;
+    if (!PyObject_TypeCheck(argument, &WorkProcType)) {
+        PyErr_SetString(PyExc_TypeError, "argument is not a work procedure");
+        return NULL;
+    }
+    work = (WorkProcObject*)argument;
+    if (work->callback) {
+        MyXtRemoveWorkProc(work->id);
+        work->id = 0;
+        Py_CLEAR(work->callback);
+        Py_DECREF(work);
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+set_event_budget(PyObject* unused, PyObject* args)
+{
+    int budget;
+    const char* name = NULL;
+    int i;
+    if (!PyArg_ParseTuple(args, "i|s", &budget, &name)) return NULL;
+    if (budget < 1) {
+        PyErr_SetString(PyExc_ValueError, "budget should be at least 1");
+        return NULL;
+    }
+    if (name == NULL) schedule.budget = budget;
+    for (i = 0; i < schedule.count; i++) {
+        DisplaySchedule* ds = &schedule.displays[i];
+        if (name == NULL || strcmp(DisplayString(ds->dpy), name) == 0)
+            ds->budget = budget;
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+display_statistics(PyObject* unused, PyObject* noargs)
+{
+    int i;
+    PyObject* list = PyList_New(0);
+    if (!list) return NULL;
+    for (i = 0; i < schedule.count; i++) {
+        DisplaySchedule* ds = &schedule.displays[i];
+        double max_latency = ds->max_latency.tv_sec
+                           + ds->max_latency.tv_usec * 1.e-6;
+        double total_latency = ds->total_latency.tv_sec
+                             + ds->total_latency.tv_usec * 1.e-6;
+        PyObject* item = Py_BuildValue(
+            "{s:s,s:i,s:k,s:k,s:k,s:d,s:d}",
+            "display", DisplayString(ds->dpy),
+            "budget", ds->budget,
+            "events", ds->events,
+            "batches", ds->batches,
+            "exhausted", ds->exhausted,
+            "max_latency", max_latency,
+            "mean_latency", ds->batches ? total_latency / ds->batches : 0.0);
+        if (!item || PyList_Append(list, item) < 0) {
+            Py_XDECREF(item);
+            Py_DECREF(list);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    return list;
+}
+
+static PyObject*
+set_work_slice(PyObject* unused, PyObject* args)
+{
+    unsigned long milliseconds;
+    if (!PyArg_ParseTuple(args, "k", &milliseconds)) return NULL;
+    work.slice.tv_sec = (time_t) (milliseconds / 1000);
+    work.slice.tv_usec = (suseconds_t) ((milliseconds % 1000) * 1000);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+work_statistics(PyObject* unused, PyObject* noargs)
+{
+    return Py_BuildValue("{s:k,s:k,s:k,s:d,s:d}",
+                         "calls", work.calls,
+                         "slices", work.slices,
+                         "preempted", work.preempted,
+                         "work_time", work.work_time.tv_sec
+                                    + work.work_time.tv_usec * 1.e-6,
+                         "idle_time", work.idle_time.tv_sec
+                                    + work.idle_time.tv_usec * 1.e-6);
+}
+
+static PyObject*
+pool_statistics(PyObject* unused, PyObject* noargs)
+{
+    size_t i;
+    PyObject* dict = PyDict_New();
+    if (!dict) return NULL;
+    for (i = 0; i < XtNumber(pools); i++) {
+        RecordPool* pool = &pools[i];
+        PyObject* item = Py_BuildValue("{s:k,s:k,s:k}",
+                                       "hits", pool->hits,
+                                       "misses", pool->misses,
+                                       "in_use", pool->in_use);
+        if (!item || PyDict_SetItemString(dict, pool->name, item) < 0) {
+            Py_XDECREF(item);
+            Py_DECREF(dict);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    return dict;
+}
+
+extern void _XtGetBindCacheStatistics(unsigned long*, unsigned long*,
+                                      unsigned long*);
+
+static PyObject*
+bind_cache_statistics(PyObject* unused, PyObject* noargs)
+{
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long entries;
+    _XtGetBindCacheStatistics(&hits, &misses, &entries);
+    return Py_BuildValue("{s:k,s:k,s:k}",
+                         "hits", hits,
+                         "misses", misses,
+                         "entries", entries);
+}
+
+extern void _XtGetGCStatistics(unsigned long*, unsigned long*,
+                               unsigned long*);
+
+static PyObject*
+gc_cache_statistics(PyObject* unused, PyObject* noargs)
+{
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long entries;
+    _XtGetGCStatistics(&hits, &misses, &entries);
+    return Py_BuildValue("{s:k,s:k,s:k}",
+                         "hits", hits,
+                         "misses", misses,
+                         "entries", entries);
+}
+
+extern void _XtGetConverterCacheStatistics(unsigned long*, unsigned long*,
+                                           unsigned long*, unsigned long*,
+                                           unsigned long*);
+extern void _XtSetConverterCacheLimit(unsigned long);
+
+static PyObject*
+converter_cache_statistics(PyObject* unused, PyObject* noargs)
+{
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    unsigned long entries;
+    unsigned long bytes;
+    _XtGetConverterCacheStatistics(&hits, &misses, &evictions, &entries,
+                                   &bytes);
+    return Py_BuildValue("{s:k,s:k,s:k,s:k,s:k}",
+                         "hits", hits,
+                         "misses", misses,
+                         "evictions", evictions,
+                         "entries", entries,
+                         "bytes", bytes);
+}
+
+static PyObject*
+set_converter_cache_limit(PyObject* unused, PyObject* args)
+{
+    unsigned long limit;
+    if (!PyArg_ParseTuple(args, "k", &limit)) return NULL;
+    _XtSetConverterCacheLimit(limit);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+translate_keycodes(PyObject* unused, PyObject* args)
+{
+    PyObject* keys;
+    PyObject* result;
+    Py_ssize_t i, n;
+    Display* dpy;
+    XtAppContext app = notifier.appContext;
+
+    if (!PyArg_ParseTuple(args, "O", &keys)) return NULL;
+    if (app == NULL || app->count == 0) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "no display has been initialized for Xt");
+        return NULL;
+    }
+    dpy = app->list[0];
+    keys = PySequence_Fast(keys, "expected a sequence of (keycode, state)");
+    if (!keys) return NULL;
+    n = PySequence_Fast_GET_SIZE(keys);
+    result = PyList_New(n);
+    if (!result) {
+        Py_DECREF(keys);
+        return NULL;
+    }
+    for (i = 0; i < n; i++) {
+        unsigned int keycode;
+        unsigned int state;
+        Modifiers modifiers;
+        KeySym keysym;
+        PyObject* item = PySequence_Fast_GET_ITEM(keys, i);
+        if (!PyArg_ParseTuple(item, "II", &keycode, &state)) {
+            Py_DECREF(result);
+            Py_DECREF(keys);
+            return NULL;
+        }
+        XtTranslateKeycode(dpy, (KeyCode) keycode, state, &modifiers, &keysym);
+        item = PyLong_FromUnsignedLong(keysym);
+        if (!item) {
+            Py_DECREF(result);
+            Py_DECREF(keys);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, item);
+    }
+    Py_DECREF(keys);
+    return result;
+}
+
+extern void _XtSetShellArenas(Boolean);
+extern void _XtGetArenaStatistics(unsigned long*, unsigned long*,
+                                  unsigned long*);
+
+static PyObject*
+set_shell_arenas(PyObject* unused, PyObject* args)
+{
+    int enable;
+    if (!PyArg_ParseTuple(args, "p", &enable)) return NULL;
+    _XtSetShellArenas(enable ? True : False);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+arena_statistics(PyObject* unused, PyObject* noargs)
+{
+    unsigned long arenas;
+    unsigned long bytes;
+    unsigned long records;
+    _XtGetArenaStatistics(&arenas, &bytes, &records);
+    return Py_BuildValue("{s:k,s:k,s:k}",
+                         "arenas", arenas,
+                         "bytes", bytes,
+                         "records", records);
+}
+
+extern void XtCreateManagedWidgets(_Xconst char*, WidgetClass, Widget,
+                                   Cardinal, ArgList, Cardinal, ArgList,
+                                   Cardinal, WidgetList);
+
+static PyObject*
+create_managed_widgets(PyObject* unused, PyObject* args)
+{
+    unsigned long address;
+    const char* name;
+    PyObject* shared;
+    PyObject* names;
+    PyObject* items;
+    int composite = 0;
+    Widget parent;
+    ArgList shared_args = NULL;
+    ArgList item_args = NULL;
+    WidgetList children = NULL;
+    Cardinal num_shared = 0;
+    Cardinal num_names;
+    Cardinal num_widgets;
+    Cardinal i, j;
+    PyObject* key;
+    PyObject* value;
+    Py_ssize_t position = 0;
+    PyObject* result = NULL;
+
+    if (!PyArg_ParseTuple(args, "ksO!OO|p", &address, &name,
+                          &PyDict_Type, &shared, &names, &items, &composite))
+        return NULL;
+    parent = (Widget) address;
+    if (parent == NULL || !XtIsComposite(parent)) {
+        PyErr_SetString(PyExc_ValueError, "parent should be a composite widget");
+        return NULL;
+    }
+    names = PySequence_Fast(names, "expected a sequence of resource names");
+    if (!names) return NULL;
+    items = PySequence_Fast(items, "expected a sequence of resource values");
+    if (!items) {
+        Py_DECREF(names);
+        return NULL;
+    }
+    num_names = (Cardinal) PySequence_Fast_GET_SIZE(names);
+    num_widgets = (Cardinal) PySequence_Fast_GET_SIZE(items);
+    shared_args = (ArgList) XtMalloc((Cardinal) (PyDict_Size(shared) + 1)
+                                     * sizeof(Arg));
+    item_args = (ArgList) XtMalloc((num_widgets * num_names + 1)
+                                   * sizeof(Arg));
+    children = (WidgetList) XtMalloc((num_widgets + 1) * sizeof(Widget));
+    while (PyDict_Next(shared, &position, &key, &value)) {
+        const char* resource = PyUnicode_AsUTF8(key);
+        long number = PyLong_AsLong(value);
+        if (!resource || (number == -1 && PyErr_Occurred())) goto exit;
+        XtSetArg(shared_args[num_shared], (String) resource, number);
+        num_shared++;
+    }
+    for (i = 0; i < num_widgets; i++) {
+        PyObject* item = PySequence_Fast_GET_ITEM(items, i);
+        if (!PySequence_Check(item)
+         || PySequence_Size(item) != (Py_ssize_t) num_names) {
+            PyErr_Format(PyExc_ValueError,
+                         "item %u should have %u values", i, num_names);
+            goto exit;
+        }
+        for (j = 0; j < num_names; j++) {
+            const char* resource;
+            long number;
+            value = PySequence_GetItem(item, j);
+            if (!value) goto exit;
+            number = PyLong_AsLong(value);
+            Py_DECREF(value);
+            if (number == -1 && PyErr_Occurred()) goto exit;
+            resource = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(names, j));
+            if (!resource) goto exit;
+            XtSetArg(item_args[i * num_names + j], (String) resource, number);
+        }
+    }
+    XtCreateManagedWidgets(name,
+                           composite ? compositeWidgetClass : widgetClass,
+                           parent, num_widgets, shared_args, num_shared,
+                           item_args, num_names, children);
+    result = PyList_New(num_widgets);
+    if (!result) goto exit;
+    for (i = 0; i < num_widgets; i++) {
+        value = PyLong_FromUnsignedLong((unsigned long) children[i]);
+        if (!value) {
+            Py_DECREF(result);
+            result = NULL;
+            goto exit;
+        }
+        PyList_SET_ITEM(result, i, value);
+    }
+exit:
+    XtFree((char*) shared_args);
+    XtFree((char*) item_args);
+    XtFree((char*) children);
+    Py_DECREF(names);
+    Py_DECREF(items);
+    return result;
+}
+
+extern void XtBeginGeometryTransaction(void);
+extern void XtCommitGeometryTransaction(void);
+extern void _XtGetGeometryStatistics(unsigned long*, unsigned long*,
+                                     unsigned long*);
+
+static PyObject*
+begin_geometry_transaction(PyObject* unused, PyObject* noargs)
+{
+    XtBeginGeometryTransaction();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+commit_geometry_transaction(PyObject* unused, PyObject* noargs)
+{
+    XtCommitGeometryTransaction();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+configure_widgets(PyObject* unused, PyObject* args)
+{
+    PyObject* items;
+    PyObject* item;
+    Py_ssize_t i, n;
+    unsigned long address;
+    int x, y;
+    unsigned int width, height, border_width;
+    if (!PyArg_ParseTuple(args, "O", &items)) return NULL;
+    items = PySequence_Fast(items, "expected a sequence of tuples");
+    if (!items) return NULL;
+    n = PySequence_Fast_GET_SIZE(items);
+    for (i = 0; i < n; i++) {
+        Widget w;
+        item = PySequence_Fast_GET_ITEM(items, i);
+        if (!PyArg_ParseTuple(item, "kiiIII;expected (widget, x, y, width, "
+                                    "height, border_width)",
+                              &address, &x, &y, &width, &height,
+                              &border_width)) {
+            Py_DECREF(items);
+            return NULL;
+        }
+        w = (Widget) address;
+        XtConfigureWidget(w, x, y, width, height, border_width);
+    }
+    Py_DECREF(items);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+geometry_statistics(PyObject* unused, PyObject* noargs)
+{
+    unsigned long recorded;
+    unsigned long sent;
+    unsigned long pending;
+    _XtGetGeometryStatistics(&recorded, &sent, &pending);
+    return Py_BuildValue("{s:k,s:k,s:k}",
+                         "recorded", recorded,
+                         "sent", sent,
+                         "pending", pending);
+}
+
+extern void XtBeginSetValuesTransaction(void);
+extern void XtCommitSetValuesTransaction(void);
+extern void _XtGetSetValuesStatistics(unsigned long*, unsigned long*,
+                                      unsigned long*);
+
+static PyObject*
+begin_set_values_transaction(PyObject* unused, PyObject* noargs)
+{
+    XtBeginSetValuesTransaction();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+commit_set_values_transaction(PyObject* unused, PyObject* noargs)
+{
+    XtCommitSetValuesTransaction();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+set_values(PyObject* unused, PyObject* args)
+{
+    PyObject* widgets;
+    PyObject* names;
+    PyObject* items;
+    ArgList arglist = NULL;
+    Cardinal num_names;
+    Cardinal num_widgets;
+    Cardinal i, j;
+    PyObject* value;
+    PyObject* result = NULL;
+
+    if (!PyArg_ParseTuple(args, "OOO", &widgets, &names, &items)) return NULL;
+    widgets = PySequence_Fast(widgets, "expected a sequence of widgets");
+    if (!widgets) return NULL;
+    names = PySequence_Fast(names, "expected a sequence of resource names");
+    if (!names) {
+        Py_DECREF(widgets);
+        return NULL;
+    }
+    items = PySequence_Fast(items, "expected a sequence of resource values");
+    if (!items) {
+        Py_DECREF(widgets);
+        Py_DECREF(names);
+        return NULL;
+    }
+    num_names = (Cardinal) PySequence_Fast_GET_SIZE(names);
+    num_widgets = (Cardinal) PySequence_Fast_GET_SIZE(widgets);
+    if (PySequence_Fast_GET_SIZE(items) != (Py_ssize_t) num_widgets) {
+        PyErr_SetString(PyExc_ValueError,
+                        "expected one item of values for each widget");
+        goto exit;
+    }
+    arglist = (ArgList) XtMalloc((num_names + 1) * sizeof(Arg));
+    XtBeginSetValuesTransaction();
+    for (i = 0; i < num_widgets; i++) {
+        PyObject* item = PySequence_Fast_GET_ITEM(items, i);
+        unsigned long address;
+        address = PyLong_AsUnsignedLong(PySequence_Fast_GET_ITEM(widgets, i));
+        if (address == (unsigned long) -1 && PyErr_Occurred()) break;
+        if (!PySequence_Check(item)
+         || PySequence_Size(item) != (Py_ssize_t) num_names) {
+            PyErr_Format(PyExc_ValueError,
+                         "item %u should have %u values", i, num_names);
+            break;
+        }
+        for (j = 0; j < num_names; j++) {
+            const char* resource;
+            long number;
+            value = PySequence_GetItem(item, j);
+            if (!value) break;
+            number = PyLong_AsLong(value);
+            Py_DECREF(value);
+            if (number == -1 && PyErr_Occurred()) break;
+            resource = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(names, j));
+            if (!resource) break;
+            XtSetArg(arglist[j], (String) resource, number);
+        }
+        if (j < num_names) break;
+        XtSetValues((Widget) address, arglist, num_names);
+    }
+    XtCommitSetValuesTransaction();
+    if (i == num_widgets) {
+        Py_INCREF(Py_None);
+        result = Py_None;
+    }
+exit:
+    XtFree((char*) arglist);
+    Py_DECREF(widgets);
+    Py_DECREF(names);
+    Py_DECREF(items);
+    return result;
+}
+
+static PyObject*
+widget_geometry(PyObject* unused, PyObject* args)
+{
+    unsigned long address;
+    Widget w;
+    if (!PyArg_ParseTuple(args, "k", &address)) return NULL;
+    w = (Widget) address;
+    return Py_BuildValue("(iiIII)",
+                         (int) w->core.x,
+                         (int) w->core.y,
+                         (unsigned int) w->core.width,
+                         (unsigned int) w->core.height,
+                         (unsigned int) w->core.border_width);
+}
+
+static PyObject*
+set_values_statistics(PyObject* unused, PyObject* noargs)
+{
+    unsigned long deferred;
+    unsigned long finished;
+    unsigned long pending;
+    _XtGetSetValuesStatistics(&deferred, &finished, &pending);
+    return Py_BuildValue("{s:k,s:k,s:k}",
+                         "deferred", deferred,
+                         "finished", finished,
+                         "pending", pending);
+}
+
+extern void _XtGetNameCacheStatistics(unsigned long*, unsigned long*,
+                                      unsigned long*);
+
+static PyObject*
+name_to_widget(PyObject* unused, PyObject* args)
+{
+    unsigned long address;
+    const char* path;
+    Widget widget;
+    if (!PyArg_ParseTuple(args, "ks", &address, &path)) return NULL;
+    widget = XtNameToWidget((Widget) address, path);
+    if (widget == NULL) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    return PyLong_FromUnsignedLong((unsigned long) widget);
+}
+
+static PyObject*
+name_cache_statistics(PyObject* unused, PyObject* noargs)
+{
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long indexes;
+    _XtGetNameCacheStatistics(&hits, &misses, &indexes);
+    return Py_BuildValue("{s:k,s:k,s:k}",
+                         "hits", hits,
+                         "misses", misses,
+                         "indexes", indexes);
+}
+
+extern void _XtSetResourceCache(_Xconst char*);
+extern void _XtGetResourceCacheStatistics(unsigned long*, unsigned long*);
+
+static PyObject*
+set_resource_cache(PyObject* unused, PyObject* args)
+{
+    const char* filename = NULL;
+    if (!PyArg_ParseTuple(args, "z", &filename)) return NULL;
+    _XtSetResourceCache(filename);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+resource_cache_statistics(PyObject* unused, PyObject* noargs)
+{
+    unsigned long hits;
+    unsigned long misses;
+    _XtGetResourceCacheStatistics(&hits, &misses);
+    return Py_BuildValue("{s:k,s:k}",
+                         "hits", hits,
+                         "misses", misses);
+}
+
+static PyObject*
+display_initialize(PyObject* unused, PyObject* args)
+{
+    const char* name;
+    const char* class;
+    Display* dpy;
+    int argc = 0;
+    struct timeval start, end;
+    if (!PyArg_ParseTuple(args, "ss", &name, &class)) return NULL;
+    dpy = XOpenDisplay(NULL);
+    if (!dpy) {
+        PyErr_SetString(PyExc_RuntimeError, "cannot open display");
+        return NULL;
+    }
+    X_GETTIMEOFDAY(&start);
+    XtDisplayInitialize(notifier.appContext, dpy, name, class, NULL, 0,
+                        &argc, NULL);
+    X_GETTIMEOFDAY(&end);
+    XtCloseDisplay(dpy);
+    return PyFloat_FromDouble((end.tv_sec - start.tv_sec)
+                            + (end.tv_usec - start.tv_usec) * 1e-6);
+}
+
+static PyObject*
+time_keycodes(PyObject* unused, PyObject* args)
+{
+    PyObject* keys;
+    Py_ssize_t i, n;
+    int round, rounds;
+    KeyCode* keycodes;
+    Modifiers* states;
+    Modifiers modifiers;
+    KeySym keysym;
+    Display* dpy;
+    XtKeyProc translator;
+    struct timeval start, middle, end;
+    double table_time, translator_time;
+    XtAppContext app = notifier.appContext;
+
+    if (!PyArg_ParseTuple(args, "Oi", &keys, &rounds)) return NULL;
+    if (app == NULL || app->count == 0) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "no display has been initialized for Xt");
+        return NULL;
+    }
+    dpy = app->list[0];
+    keys = PySequence_Fast(keys, "expected a sequence of (keycode, state)");
+    if (!keys) return NULL;
+    n = PySequence_Fast_GET_SIZE(keys);
+    if (n == 0 || rounds < 1) {
+        Py_DECREF(keys);
+        PyErr_SetString(PyExc_ValueError, "expected keys and rounds");
+        return NULL;
+    }
+    keycodes = PyMem_New(KeyCode, n);
+    states = PyMem_New(Modifiers, n);
+    if (!keycodes || !states) {
+        PyMem_Free(keycodes);
+        PyMem_Free(states);
+        Py_DECREF(keys);
+        return PyErr_NoMemory();
+    }
+    for (i = 0; i < n; i++) {
+        unsigned int keycode;
+        unsigned int state;
+        PyObject* item = PySequence_Fast_GET_ITEM(keys, i);
+        if (!PyArg_ParseTuple(item, "II", &keycode, &state)) {
+            PyMem_Free(keycodes);
+            PyMem_Free(states);
+            Py_DECREF(keys);
+            return NULL;
+        }
+        keycodes[i] = (KeyCode) keycode;
+        states[i] = (Modifiers) state;
+    }
+    Py_DECREF(keys);
+
+    /* Builds the keysym and keycode tables before timing */
+    XtTranslateKeycode(dpy, keycodes[0], states[0], &modifiers, &keysym);
+    translator = _XtGetPerDisplay(dpy)->defaultKeycodeTranslator;
+    X_GETTIMEOFDAY(&start);
+    for (round = 0; round < rounds; round++)
+        for (i = 0; i < n; i++)
+            XtTranslateKeycode(dpy, keycodes[i], states[i], &modifiers,
+                               &keysym);
+    X_GETTIMEOFDAY(&middle);
+    /* The path taken before the keycode tables: the translator itself */
+    for (round = 0; round < rounds; round++)
+        for (i = 0; i < n; i++)
+            (*translator) (dpy, keycodes[i], states[i], &modifiers, &keysym);
+    X_GETTIMEOFDAY(&end);
+    PyMem_Free(keycodes);
+    PyMem_Free(states);
+
+    table_time = (middle.tv_sec - start.tv_sec)
+               + (middle.tv_usec - start.tv_usec) * 1e-6;
+    translator_time = (end.tv_sec - middle.tv_sec)
+                    + (end.tv_usec - middle.tv_usec) * 1e-6;
+    return Py_BuildValue("{s:d,s:d}",
+                         "table_ns_per_key",
+                         table_time / rounds / n * 1e9,
+                         "translator_ns_per_key",
+                         translator_time / rounds / n * 1e9);
+}
+
+static PyObject*
+set_event_coalescing(PyObject* unused, PyObject* args)
+{
+    unsigned long address;
+    int configure;
+    int motion_history;
+    int flags = 0;
+    if (!PyArg_ParseTuple(args, "kpp", &address, &configure, &motion_history))
+        return NULL;
+    if (configure) flags |= MyCoalesceConfigure;
+    if (motion_history) flags |= MyCoalesceMotionHistory;
+    MySetCoalescing(XtClass((Widget) address), flags);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+motion_history(PyObject* unused, PyObject* args)
+{
+    unsigned long address;
+    XMotionEvent* events;
+    Cardinal num_events;
+    Cardinal i;
+    PyObject* list;
+    if (!PyArg_ParseTuple(args, "k", &address)) return NULL;
+    events = MyXtGetMotionHistory(XtDisplay((Widget) address), &num_events);
+    list = PyList_New(num_events);
+    if (!list) return NULL;
+    for (i = 0; i < num_events; i++) {
+        PyObject* item = Py_BuildValue("(iik)", events[i].x, events[i].y,
+                                       (unsigned long) events[i].time);
+        if (!item) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    return list;
+}
+
+/* Callback to handle mouse clicks */
+static void button_callback1(Widget w, XtPointer client_data, XEvent *event, Boolean *cont) {
+    if (event->type == ButtonPress) {
+        printf("Xt button clicked\n");
+    }
+}
+
+static void timer_proc (XtPointer client_data, XtIntervalId *timer)
+{
+    static int counter = 0;
+    printf("Xt timer update %d\n", counter++);
+    MyXtAppAddTimeOut(notifier.appContext, 1500, timer_proc, NULL);
+}
+
+static int pipefds[2];
+
+static void pipe_proc (XtPointer client_data, int *source, XtInputId *id)
+{
+    char c;
+    int n;
+    printf("Xt file descriptor triggered\n");
+    n = read(pipefds[0], &c, 1);
+    if (n != 1) {
+        fprintf(stderr, "**** FAILED TO READ DATA\n");
+        fflush(stderr);
+    }
+}
+
+static void button_callback2(Widget w, XtPointer client_data, XEvent *event, Boolean *cont) {
+    if (event->type == ButtonPress) {
+        char c = '\n';
+        int n = write(pipefds[1], &c, 1);
+        if (n != 1) {
+            fprintf(stderr, "**** FAILED TO READ DATA\n");
+            fflush(stderr);
+        }
+    }
+}
+
+static void button_callback3(Widget w, XtPointer client_data, XEvent *event, Boolean *cont) {
+    if (event->type == ButtonPress) {
+        MyXtAppAddTimeOut(notifier.appContext, 1500, timer_proc, NULL);
+    }
+}
+
+/* Expose handler to draw the button rectangle + label */
+static void expose_callback(Widget w, XtPointer client_data, XEvent *event, Boolean *cont) {
+    if (event->type == Expose) {
+        Display *dpy = XtDisplay(w);
+        Window win = XtWindow(w);
+        GC gc = XCreateGC(dpy, win, 0, NULL);
+
+        XFontStruct *font = XLoadQueryFont(dpy, "-*-helvetica-bold-r-*-*-48-*-*-*-*-*-*-*");
+        if (font) XSetFont(dpy, gc, font->fid);
+        const char *msg = "Xt";
+        int len = strlen(msg);
+        int dir, asc, desc;
+        XCharStruct overall;
+        XTextExtents(font, msg, len, &dir, &asc, &desc, &overall);
+        int x = (400 - overall.width) / 2;
+	int y = (100 + asc - desc) / 2;
+        XDrawString(dpy, win, gc, x, y, msg, len);
+        XFreeGC(dpy, gc);
+        if (font) XFreeFont(dpy, font);
+    }
+}
+
+/* Expose handler to draw the button rectangle + label */
 static void expose_callback1(Widget w, XtPointer client_data, XEvent *event, Boolean *cont) {
     if (event->type == Expose) {
         Display *dpy = XtDisplay(w);
@@ -2884,20 +4916,69 @@ delete_window_handler(Widget w, XtPointer client_data, XtPointer call_data)
     exit(0);
 }
 
+/*
+ * Tk generic handler for a display shared with Xt.  Events that Tk read for
+ * Xt widget windows are passed on to Xt; the Xt loop does the reverse for
+ * all other windows in MyProcessXEvent.
+ */
+static int
+SharedDisplayHandler(ClientData clientData, XEvent *eventPtr)
+{
+    Display *dpy = (Display *) clientData;
+
+    if (eventPtr->xany.display != dpy ||
+        XtWindowToWidget(dpy, eventPtr->xany.window) == NULL)
+        return 0;
+    MyXtDispatchEvent(eventPtr);
+    return 1;
+}
+
 static PyObject* simple(PyObject* unused, PyObject* args) {
     Widget top, container, label, button1, button2, button3;
     int argc = 0;
     Display *dpy = NULL;
+    unsigned long interpaddr = 0;
+    int result;
+
+    if (!PyArg_ParseTuple(args, "|k", &interpaddr)) return NULL;
+
+    if (interpaddr) {
+        Tcl_Interp *interp = (Tcl_Interp *) interpaddr;
+        Tk_Window tkwin = Tk_MainWindow(interp);
+        if (tkwin == NULL) {
+            PyErr_Format(PyExc_RuntimeError, "%s", Tcl_GetStringResult(interp));
+            return NULL;
+        }
+        dpy = Tk_Display(tkwin);
+        if (notifier.sharedDisplay && dpy != notifier.sharedDisplay) {
+            PyErr_SetString(PyExc_RuntimeError,
+                            "Xt already shares a different Tk display");
+            return NULL;
+        }
+    }
 
-    int result = pipe(pipefds);
+    result = pipe(pipefds);
     if (result == -1) {
         PyErr_Format(PyExc_RuntimeError,
                      "failed to create pipe (errno %d)", errno);
         return NULL;
     }
 
-    dpy = XOpenDisplay(NULL);
-    XtDisplayInitialize(notifier.appContext, dpy, "hello", "Hello", NULL, 0, &argc, NULL);
+    if (dpy == NULL) {
+        dpy = XOpenDisplay(NULL);
+        XtDisplayInitialize(notifier.appContext, dpy, "hello", "Hello", NULL, 0, &argc, NULL);
+    }
+    else if (notifier.sharedDisplay == NULL) {
+        notifier.sharedDisplay = dpy;
+        Tk_CreateGenericHandler(SharedDisplayHandler, dpy);
+        /*
+         * The Xt loop reads the connection as one of its displays, so Tk's
+         * own file handler on it is not needed.  Tk still takes events that
+         * are already queued when it processes events itself.
+         */
+        Tcl_DeleteFileHandler(ConnectionNumber(dpy));
+        XtDisplayInitialize(notifier.appContext, dpy, "hello", "Hello", NULL, 0, &argc, NULL);
+    }
     top = XtAppCreateShell("hello", "Hello", applicationShellWidgetClass, dpy, NULL, 0);
 
     container = XtVaCreateManagedWidget("container",
@@ -2967,8 +5048,7 @@ static PyObject* simple(PyObject* unused, PyObject* args) {
     XtAddEventHandler(top, NoEventMask, True, wm_protocol_handler, NULL);
     XtAddCallback(top, XtNdestroyCallback, delete_window_handler, NULL);
 
-    Py_INCREF(Py_None);
-    return Py_None;
+    return PyLong_FromUnsignedLong((unsigned long) container);
 }
 
 static struct PyMethodDef methods[] = {
@@ -2977,10 +5057,257 @@ static struct PyMethodDef methods[] = {
      METH_NOARGS,
      "Starts the Tcl/Tk event loop."
     }, 
+    {"stop",
+     (PyCFunction)stop,
+     METH_NOARGS,
+     "Makes start() return after the event being handled."
+    },
     {"simple",
      (PyCFunction)simple,
+     METH_VARARGS,
+     "Creates a simple X11 window using X/Xt only. If the address of a Tcl "
+     "interpreter with Tk loaded is given (as returned by tk.interpaddr()), "
+     "the window is created on Tk's display connection instead of opening "
+     "a new one. Returns the address of the composite widget holding the "
+     "window's contents."
+    },
+    {"set_event_budget",
+     (PyCFunction)set_event_budget,
+     METH_VARARGS,
+     "Sets the number of X events dispatched from a display each time the "
+     "Xt loop services it; for all displays, or for the named display only."
+    },
+    {"display_statistics",
+     (PyCFunction)display_statistics,
+     METH_NOARGS,
+     "Returns a list of dictionaries with event and latency counters for "
+     "each display served by the Xt loop. Latencies are in seconds."
+    },
+    {"pool_statistics",
+     (PyCFunction)pool_statistics,
+     METH_NOARGS,
+     "Returns the hits, misses and records in use of the record pools for "
+     "inputs, timers and work procedures. A miss allocates a new chunk."
+    },
+    {"bind_cache_statistics",
+     (PyCFunction)bind_cache_statistics,
      METH_NOARGS,
-     "Creates a simple X11 window using X/Xt only."
+     "Returns the hits and misses of the Xt translation bind cache, and the "
+     "number of action bindings it holds."
+    },
+    {"gc_cache_statistics",
+     (PyCFunction)gc_cache_statistics,
+     METH_NOARGS,
+     "Returns the number of XtGetGC and XtAllocateGC requests that shared "
+     "an existing GC, the number that created a new one, and the number of "
+     "shared GCs in use."
+    },
+    {"converter_cache_statistics",
+     (PyCFunction)converter_cache_statistics,
+     METH_NOARGS,
+     "Returns the hits, misses and evictions of the Xt resource conversion "
+     "cache, the number of entries it holds, and the size in bytes of the "
+     "entries that may be evicted."
+    },
+    {"set_converter_cache_limit",
+     (PyCFunction)set_converter_cache_limit,
+     METH_VARARGS,
+     "Bounds the size in bytes of the XtCacheAll conversion results made "
+     "from now on; the least recently used are evicted first. A limit of 0 "
+     "removes the bound."
+    },
+    {"set_shell_arenas",
+     (PyCFunction)set_shell_arenas,
+     METH_VARARGS,
+     "Enables or disables arenas for new shells. The records of widgets "
+     "created under a shell with an arena are allocated from large chunks "
+     "that are freed together when the shell is destroyed."
+    },
+    {"arena_statistics",
+     (PyCFunction)arena_statistics,
+     METH_NOARGS,
+     "Returns the number of shells with an arena, the total size in bytes "
+     "of their chunks, and the number of live widget records they hold."
+    },
+    {"create_managed_widgets",
+     (PyCFunction)create_managed_widgets,
+     METH_VARARGS,
+     "create_managed_widgets(parent, name, args, names, items, composite=False)"
+     "\n\nCreates one managed Core (or Composite) widget named name for each "
+     "item under the composite widget at address parent, and manages them "
+     "together. Each widget gets the integer resources in the dictionary "
+     "args, overridden by the values of the resources in names given by its "
+     "item. Returns the addresses of the new widgets."
+    },
+    {"begin_geometry_transaction",
+     (PyCFunction)begin_geometry_transaction,
+     METH_NOARGS,
+     "Starts a geometry transaction. Until the matching "
+     "commit_geometry_transaction, window configurations of non-shell "
+     "widgets are merged per widget instead of being sent to the server. "
+     "Transactions nest."
+    },
+    {"commit_geometry_transaction",
+     (PyCFunction)commit_geometry_transaction,
+     METH_NOARGS,
+     "Ends a geometry transaction. The outermost commit sends one "
+     "ConfigureWindow request per changed widget and flushes the display."
+    },
+    {"configure_widgets",
+     (PyCFunction)configure_widgets,
+     METH_VARARGS,
+     "Calls XtConfigureWidget for each (widget, x, y, width, height, "
+     "border_width) tuple in the sequence, where widget is an address."
+    },
+    {"geometry_statistics",
+     (PyCFunction)geometry_statistics,
+     METH_NOARGS,
+     "Returns the number of window configurations recorded inside geometry "
+     "transactions, the number of ConfigureWindow requests sent for them at "
+     "commit, and the number of widgets currently pending."
+    },
+    {"begin_set_values_transaction",
+     (PyCFunction)begin_set_values_transaction,
+     METH_NOARGS,
+     "Starts a SetValues transaction. Until the matching "
+     "commit_set_values_transaction, XtSetValues applies resource values "
+     "at once but merges the geometry requests and redisplays of each "
+     "widget. Transactions nest."
+    },
+    {"commit_set_values_transaction",
+     (PyCFunction)commit_set_values_transaction,
+     METH_NOARGS,
+     "Ends a SetValues transaction. The outermost commit negotiates the "
+     "geometry of and redisplays each changed widget once."
+    },
+    {"set_values",
+     (PyCFunction)set_values,
+     METH_VARARGS,
+     "set_values(widgets, names, items)\n\nSets the integer resources in "
+     "names on each widget address in widgets to the values in the "
+     "corresponding item, inside one SetValues transaction."
+    },
+    {"widget_geometry",
+     (PyCFunction)widget_geometry,
+     METH_VARARGS,
+     "Returns the (x, y, width, height, border_width) of the widget at the "
+     "given address, as XtGetValues would."
+    },
+    {"set_values_statistics",
+     (PyCFunction)set_values_statistics,
+     METH_NOARGS,
+     "Returns the number of XtSetValues calls deferred by SetValues "
+     "transactions, the number of widgets finished at commit, and the "
+     "number of widgets currently pending."
+    },
+    {"name_to_widget",
+     (PyCFunction)name_to_widget,
+     METH_VARARGS,
+     "name_to_widget(root, path)\n\nReturns the address of the widget "
+     "that XtNameToWidget finds for path under the widget at address root, "
+     "or None."
+    },
+    {"name_cache_statistics",
+     (PyCFunction)name_cache_statistics,
+     METH_NOARGS,
+     "Returns the hits and misses of the XtNameToWidget path cache, and "
+     "the number of composites with a child name index."
+    },
+    {"set_resource_cache",
+     (PyCFunction)set_resource_cache,
+     METH_VARARGS,
+     "Names the file in which the resources of the app-defaults files are "
+     "cached in compiled form, or disables the cache if None. Displays "
+     "initialized later skip resolving and parsing these files while none "
+     "of the candidate files has changed."
+    },
+    {"resource_cache_statistics",
+     (PyCFunction)resource_cache_statistics,
+     METH_NOARGS,
+     "Returns the hits and misses of the compiled resource cache."
+    },
+    {"display_initialize",
+     (PyCFunction)display_initialize,
+     METH_VARARGS,
+     "display_initialize(name, class)\n\nOpens a new connection to the "
+     "default display, initializes it for Xt with the application name and "
+     "class, closes it again, and returns the seconds spent in "
+     "XtDisplayInitialize."
+    },
+    {"set_event_coalescing",
+     (PyCFunction)set_event_coalescing,
+     METH_VARARGS,
+     "set_event_coalescing(widget, configure, motion_history)\n\nSets how "
+     "queued events are coalesced for the widget class of the widget at "
+     "address widget. If configure is True, only the last of a run of "
+     "ConfigureNotify events is dispatched. If motion_history is True, the "
+     "MotionNotify events coalesced by compress_motion are recorded for "
+     "motion_history()."
+    },
+    {"motion_history",
+     (PyCFunction)motion_history,
+     METH_VARARGS,
+     "Returns the (x, y, time) tuples of the last run of MotionNotify "
+     "events that was coalesced and recorded on the display of the widget "
+     "at the given address, oldest first."
+    },
+    {"translate_keycodes",
+     (PyCFunction)translate_keycodes,
+     METH_VARARGS,
+     "Translates a sequence of (keycode, state) pairs to keysyms with the Xt "
+     "key translator of the first display in the Xt application context."
+    },
+    {"time_keycodes",
+     (PyCFunction)time_keycodes,
+     METH_VARARGS,
+     "time_keycodes(keys, rounds)\n\nTranslates the sequence of (keycode, "
+     "state) pairs rounds times, both with XtTranslateKeycode and by calling "
+     "the display's key translator directly as Xt did before the keycode "
+     "tables, and returns the nanoseconds per key of each."
+    },
+    {"add_input",
+     (PyCFunction)add_input,
+     METH_VARARGS,
+     "Calls callback(fd, mask) from the Xt loop when fd becomes ready."
+    },
+    {"remove_input",
+     (PyCFunction)py_remove_input,
+     METH_O,
+     "Removes an input source created by add_input."
+    },
+    {"add_timeout",
+     (PyCFunction)add_timeout,
+     METH_VARARGS,
+     "Calls callback() from the Xt loop after a number of milliseconds."
+    },
+    {"remove_timeout",
+     (PyCFunction)remove_timeout,
+     METH_O,
+     "Removes a timeout created by add_timeout."
+    },
+    {"add_work_proc",
+     (PyCFunction)add_work_proc,
+     METH_VARARGS,
+     "Calls callback() from the Xt loop when idle, until it returns True. "
+     "Work procedures with a higher priority (default 0) are called first."
+    },
+    {"remove_work_proc",
+     (PyCFunction)remove_work_proc,
+     METH_O,
+     "Removes a work procedure created by add_work_proc."
+    },
+    {"set_work_slice",
+     (PyCFunction)set_work_slice,
+     METH_VARARGS,
+     "Sets the number of milliseconds that work procedures may run for "
+     "before the Xt loop checks for events again (default 10)."
+    },
+    {"work_statistics",
+     (PyCFunction)work_statistics,
+     METH_NOARGS,
+     "Returns a dictionary with the number of work procedure calls, the "
+     "time spent in them, and the time the Xt loop spent blocked waiting "
+     "for input, in seconds."
     },
     {NULL, NULL, 0, NULL} /* sentinel */
 };
@@ -2995,7 +5322,15 @@ static struct PyModuleDef moduledef = {
 
 PyObject* PyInit_events_tcltk(void)
 {
-    Tcl_Interp* interpreter = Tcl_CreateInterp();
+    PyObject *module;
+    Tcl_Interp* interpreter;
+    if (PyType_Ready(&InputType) < 0)
+        return NULL;
+    if (PyType_Ready(&TimeoutType) < 0)
+        return NULL;
+    if (PyType_Ready(&WorkProcType) < 0)
+        return NULL;
+    interpreter = Tcl_CreateInterp();
     if (interpreter == NULL) {
         PyErr_Format(PyExc_RuntimeError, "failed to create Tcl interpreter");   
         return NULL;
@@ -3012,5 +5347,14 @@ PyObject* PyInit_events_tcltk(void)
 #ifndef __lock_lint
     nullRegion = XCreateRegion();
 #endif
-    return PyModule_Create(&moduledef);
+    module = PyModule_Create(&moduledef);
+    if (module == NULL)
+        return NULL;
+    if (PyModule_AddIntConstant(module, "READABLE", TCL_READABLE) < 0 ||
+        PyModule_AddIntConstant(module, "WRITABLE", TCL_WRITABLE) < 0 ||
+        PyModule_AddIntConstant(module, "EXCEPTION", TCL_EXCEPTION) < 0) {
+        Py_DECREF(module);
+        return NULL;
+    }
+    return module;
 }
@@ -0,0 +1,119 @@
+"""Replay a typing burst through the Xt key translator of events_tcltk.
+
+The burst is a few paragraphs of mixed-case text with Shift held for
+capitals, as a fast typist produces it: one KeyPress and one KeyRelease
+per character. Each (keycode, state) pair goes through XtTranslateKeycode
+on an Xvfb display, unless --display is given. The keys are timed in C,
+both through the keycode table of XtTranslateKeycode and through the
+display's key translator called directly, as Xt did before the table.
+The time per key of each and the number of mistranslated keys are
+written as JSON.
+
+    python Tests/benchmark_keysyms.py --output keysyms.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+from benchmark_notifier import Xlib, start_xvfb
+
+
+TEXT = ("The Quick Brown Fox Jumps Over The Lazy Dog, "
+        "while Pack My Box With Five Dozen Liquor Jugs. "
+        "Sphinx of black quartz, JUDGE MY VOW; "
+        "how vexingly quick daft zebras jump! ") * 8
+
+ShiftMask = 1
+KeyPress = 2
+KeyRelease = 3
+
+
+def burst(xlib):
+    keys = []
+    expected = []
+    for character in TEXT:
+        name = {" ": "space", ",": "comma", ".": "period", ";": "semicolon",
+                "!": "exclam"}.get(character, character)
+        keysym = xlib.lib.XStringToKeysym(name.encode())
+        keycode = xlib.lib.XKeysymToKeycode(xlib.display, keysym)
+        if keycode == 0:
+            continue
+        state = ShiftMask if character.isupper() or character == "!" else 0
+        keys.append((keycode, state))
+        expected.append(keysym)
+        keys.append((keycode, state))
+        expected.append(keysym)
+    return keys, expected
+
+
+def run_child(rounds):
+    import tkinter
+    from guitk import events_tcltk
+    import ctypes
+    xlib = Xlib()
+    xlib.lib.XStringToKeysym.restype = ctypes.c_ulong
+    xlib.lib.XStringToKeysym.argtypes = [ctypes.c_char_p]
+    xlib.lib.XKeysymToKeycode.restype = ctypes.c_ubyte
+    xlib.lib.XKeysymToKeycode.argtypes = [ctypes.c_void_p, ctypes.c_ulong]
+    window = tkinter.Tk()
+    events_tcltk.simple(window.tk.interpaddr())
+    keys, expected = burst(xlib)
+    keysyms = events_tcltk.translate_keycodes(keys)   # builds the tables
+    mistranslated = sum(keysym != want
+                        for keysym, want in zip(keysyms, expected))
+    times = [events_tcltk.time_keycodes(keys, rounds) for i in range(5)]
+    result = {"keys": len(keys),
+              "rounds": rounds,
+              "table_ns_per_key":
+                  min(t["table_ns_per_key"] for t in times),
+              "translator_ns_per_key":
+                  min(t["translator_ns_per_key"] for t in times),
+              "mistranslated": mistranslated}
+    print(json.dumps(result), flush=True)
+    os._exit(0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--display",
+                        help="use this X display instead of starting Xvfb")
+    parser.add_argument("--output", help="write the JSON results to a file")
+    parser.add_argument("--rounds", type=int, default=200)
+    parser.add_argument("--child", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+    if args.child:
+        run_child(args.rounds)
+    process = None
+    environment = dict(os.environ)
+    if args.display:
+        environment["DISPLAY"] = args.display
+    else:
+        process, environment["DISPLAY"] = start_xvfb()
+    try:
+        command = [sys.executable, __file__, "--child",
+                   "--rounds", str(args.rounds)]
+        output = subprocess.run(command, env=environment,
+                                capture_output=True, text=True, timeout=120)
+    finally:
+        if process is not None:
+            process.terminate()
+            process.wait()
+    lines = output.stdout.strip().splitlines()
+    try:
+        result = json.loads(lines[-1])
+    except (IndexError, ValueError):
+        result = {"error": output.stderr.strip()}
+    text = json.dumps({"display": environment["DISPLAY"],
+                       "typing": result}, indent=2)
+    if args.output:
+        with open(args.output, "w") as stream:
+            stream.write(text + "\n")
+    else:
+        print(text)
+
+
+if __name__ == "__main__":
+    main()
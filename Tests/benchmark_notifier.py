@@ -0,0 +1,311 @@
+"""Compare the stock Tcl notifier of tkinter with the Xt notifier of events_tcltk.
+
+Each benchmark runs in a fresh process, once with the stock notifier
+(tkinter mainloop) and once with events_tcltk.start(), on an Xvfb server
+unless --display is given. The results are written as JSON.
+
+    python Tests/benchmark_notifier.py --output results.json
+"""
+
+import argparse
+import ctypes
+import ctypes.util
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import time
+
+
+MODES = ("stock", "xt")
+BENCHMARKS = ("timers", "filehandler", "buttonpress", "expose", "idle")
+
+
+# Minimal Xlib bindings to inject events from a second connection.
+
+class XButtonEvent(ctypes.Structure):
+    _fields_ = [("type", ctypes.c_int),
+                ("serial", ctypes.c_ulong),
+                ("send_event", ctypes.c_int),
+                ("display", ctypes.c_void_p),
+                ("window", ctypes.c_ulong),
+                ("root", ctypes.c_ulong),
+                ("subwindow", ctypes.c_ulong),
+                ("time", ctypes.c_ulong),
+                ("x", ctypes.c_int),
+                ("y", ctypes.c_int),
+                ("x_root", ctypes.c_int),
+                ("y_root", ctypes.c_int),
+                ("state", ctypes.c_uint),
+                ("button", ctypes.c_uint),
+                ("same_screen", ctypes.c_int)]
+
+
+class XEvent(ctypes.Union):
+    _fields_ = [("type", ctypes.c_int),
+                ("xbutton", XButtonEvent),
+                ("pad", ctypes.c_long * 24)]
+
+
+ButtonPress = 4
+ButtonPressMask = 1 << 2
+
+
+class Xlib:
+
+    def __init__(self):
+        self.lib = ctypes.CDLL(ctypes.util.find_library("X11"))
+        self.lib.XOpenDisplay.restype = ctypes.c_void_p
+        self.lib.XOpenDisplay.argtypes = [ctypes.c_char_p]
+        self.lib.XSendEvent.argtypes = [ctypes.c_void_p, ctypes.c_ulong,
+                                        ctypes.c_int, ctypes.c_long,
+                                        ctypes.POINTER(XEvent)]
+        self.lib.XClearArea.argtypes = [ctypes.c_void_p, ctypes.c_ulong,
+                                        ctypes.c_int, ctypes.c_int,
+                                        ctypes.c_uint, ctypes.c_uint,
+                                        ctypes.c_int]
+        self.lib.XFlush.argtypes = [ctypes.c_void_p]
+        self.display = self.lib.XOpenDisplay(None)
+        if not self.display:
+            raise RuntimeError("cannot open display %s" % os.environ.get("DISPLAY"))
+
+    def press_button(self, window):
+        event = XEvent()
+        event.xbutton.type = ButtonPress
+        event.xbutton.send_event = 1
+        event.xbutton.window = window
+        event.xbutton.x = event.xbutton.y = 5
+        event.xbutton.button = 1
+        event.xbutton.same_screen = 1
+        self.lib.XSendEvent(self.display, window, 1, ButtonPressMask,
+                            ctypes.byref(event))
+        self.lib.XFlush(self.display)
+
+    def expose(self, windows):
+        for window in windows:
+            self.lib.XClearArea(self.display, window, 0, 0, 0, 0, 1)
+        self.lib.XFlush(self.display)
+
+
+# The benchmarks; each one calls done(result) when it has finished.
+
+def bench_timers(window, done, count=200, delay=5):
+    errors = []
+
+    def fire(scheduled):
+        errors.append((time.perf_counter() - scheduled) * 1000 - delay)
+        if len(errors) < count:
+            window.after(delay, fire, time.perf_counter())
+        else:
+            done({"count": count,
+                  "delay_ms": delay,
+                  "mean_error_ms": statistics.mean(errors),
+                  "stdev_error_ms": statistics.stdev(errors),
+                  "max_error_ms": max(errors)})
+
+    window.after(delay, fire, time.perf_counter())
+
+
+def bench_filehandler(window, done, duration=2.0):
+    import tkinter
+    reading_fd, writing_fd = os.pipe()
+    state = {"count": 0, "start": time.perf_counter()}
+
+    def handle_io(fd, mask):
+        os.read(fd, 1)
+        state["count"] += 1
+        elapsed = time.perf_counter() - state["start"]
+        if elapsed < duration:
+            os.write(writing_fd, b"x")
+        else:
+            window.tk.deletefilehandler(reading_fd)
+            done({"callbacks": state["count"],
+                  "seconds": elapsed,
+                  "callbacks_per_second": state["count"] / elapsed})
+
+    window.tk.createfilehandler(reading_fd, tkinter.READABLE, handle_io)
+    os.write(writing_fd, b"x")
+
+
+def bench_buttonpress(window, done, count=100, interval=10):
+    import tkinter
+    xlib = Xlib()
+    button = tkinter.Button(window, text="Click me")
+    button.pack()
+    latencies = []
+    state = {}
+
+    def pressed(event):
+        latencies.append((time.perf_counter() - state["sent"]) * 1000)
+        if len(latencies) < count:
+            window.after(interval, send)
+        else:
+            done({"count": count,
+                  "mean_latency_ms": statistics.mean(latencies),
+                  "median_latency_ms": statistics.median(latencies),
+                  "max_latency_ms": max(latencies)})
+
+    def send():
+        state["sent"] = time.perf_counter()
+        xlib.press_button(button.winfo_id())
+
+    button.bind("<ButtonPress-1>", pressed)
+    window.update_idletasks()
+    window.after(100, send)
+
+
+def bench_expose(window, done, rows=20, columns=20, rounds=20):
+    import tkinter
+    xlib = Xlib()
+    frames = []
+    for row in range(rows):
+        for column in range(columns):
+            frame = tkinter.Frame(window, width=20, height=20)
+            frame.grid(row=row, column=column)
+            frames.append(frame)
+    total = len(frames)
+    times = []
+    state = {"seen": 0}
+
+    def exposed(event):
+        state["seen"] += 1
+        if state["seen"] < total:
+            return
+        times.append((time.perf_counter() - state["sent"]) * 1000)
+        if len(times) < rounds:
+            window.after(10, storm)
+        else:
+            done({"windows": total,
+                  "rounds": rounds,
+                  "mean_round_ms": statistics.mean(times),
+                  "max_round_ms": max(times)})
+
+    def storm():
+        state["seen"] = 0
+        state["sent"] = time.perf_counter()
+        xlib.expose([frame.winfo_id() for frame in frames])
+
+    for frame in frames:
+        frame.bind("<Expose>", exposed)
+    window.update()
+    window.after(100, storm)
+
+
+def bench_idle(window, done, duration=2.0):
+    start = time.perf_counter()
+    cpu = time.process_time()
+
+    def finish():
+        elapsed = time.perf_counter() - start
+        used = time.process_time() - cpu
+        done({"seconds": elapsed,
+              "cpu_seconds": used,
+              "cpu_fraction": used / elapsed})
+
+    window.after(int(duration * 1000), finish)
+
+
+def run_child(mode, name):
+    if mode == "xt":
+        from guitk import events_tcltk
+    import tkinter
+    window = tkinter.Tk()
+
+    def done(result):
+        print(json.dumps(result), flush=True)
+        if mode == "xt":
+            events_tcltk.stop()
+        else:
+            window.quit()
+
+    benchmark = globals()["bench_" + name]
+    window.after_idle(benchmark, window, done)
+    if mode == "xt":
+        events_tcltk.start()
+    else:
+        window.mainloop()
+    os._exit(0)
+
+
+def start_xvfb():
+    xvfb = shutil.which("Xvfb")
+    if xvfb is None:
+        sys.exit("Xvfb not found; install it or pass --display")
+    for number in range(99, 200):
+        if not os.path.exists("/tmp/.X%d-lock" % number):
+            break
+    display = ":%d" % number
+    process = subprocess.Popen([xvfb, display, "-screen", "0", "1024x768x24",
+                                "-nolisten", "tcp"],
+                               stdout=subprocess.DEVNULL,
+                               stderr=subprocess.DEVNULL)
+    for attempt in range(50):
+        if os.path.exists("/tmp/.X11-unix/X%d" % number):
+            break
+        time.sleep(0.1)
+    return process, display
+
+
+def run_parent(args):
+    process = None
+    environment = dict(os.environ)
+    if args.display:
+        environment["DISPLAY"] = args.display
+    else:
+        process, environment["DISPLAY"] = start_xvfb()
+    results = {}
+    try:
+        for mode in args.modes:
+            results[mode] = {}
+            for name in args.benchmarks:
+                command = [sys.executable, __file__, "--child", mode, name]
+                try:
+                    output = subprocess.run(command, env=environment,
+                                            capture_output=True, text=True,
+                                            timeout=args.timeout)
+                except subprocess.TimeoutExpired:
+                    results[mode][name] = {"error": "timed out"}
+                    continue
+                lines = output.stdout.strip().splitlines()
+                try:
+                    results[mode][name] = json.loads(lines[-1])
+                except (IndexError, ValueError):
+                    results[mode][name] = {"error": output.stderr.strip()}
+    finally:
+        if process is not None:
+            process.terminate()
+            process.wait()
+    report = {"display": environment["DISPLAY"],
+              "python": sys.version.split()[0],
+              "results": results}
+    text = json.dumps(report, indent=2)
+    if args.output:
+        with open(args.output, "w") as stream:
+            stream.write(text + "\n")
+    else:
+        print(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--display",
+                        help="use this X display instead of starting Xvfb")
+    parser.add_argument("--output", help="write the JSON results to a file")
+    parser.add_argument("--modes", nargs="+", choices=MODES, default=MODES)
+    parser.add_argument("--benchmarks", nargs="+", choices=BENCHMARKS,
+                        default=BENCHMARKS)
+    parser.add_argument("--timeout", type=float, default=60,
+                        help="seconds allowed for each benchmark")
+    parser.add_argument("--child", nargs=2, metavar=("MODE", "BENCHMARK"),
+                        help=argparse.SUPPRESS)
+    args = parser.parse_args()
+    if args.child:
+        run_child(*args.child)
+    else:
+        run_parent(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+"""Time XtDisplayInitialize with and without the compiled resource cache.
+
+The application class gets large generated app-defaults files, as both
+user and system defaults, in a temporary directory named through
+XUSERFILESEARCHPATH and XFILESEARCHPATH. Each round opens a display,
+initializes it for Xt, and closes it again; only XtDisplayInitialize is
+timed. This runs on an Xvfb display, unless --display is given. The
+results are written as JSON.
+
+    python Tests/benchmark_startup.py --output startup.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+from benchmark_notifier import start_xvfb
+
+
+CLASS = "Bench"
+
+
+def write_defaults(directory, resources):
+    os.makedirs(os.path.join(directory, "app-defaults"))
+    with open(os.path.join(directory, "app-defaults", CLASS), "w") as stream:
+        for i in range(resources):
+            stream.write("%s*panel%d.row%d.label: Label number %d\n"
+                         % (CLASS, i % 50, i, i))
+            stream.write("%s*panel%d.row%d.background: #%06x\n"
+                         % (CLASS, i % 50, i, i * 2654435761 % 0xffffff))
+    with open(os.path.join(directory, CLASS), "w") as stream:
+        for i in range(resources // 10):
+            stream.write("%s*panel%d.row%d.foreground: black\n"
+                         % (CLASS, i % 50, i))
+
+
+def run_child(rounds, directory):
+    from guitk import events_tcltk
+
+    def measure():
+        times = [events_tcltk.display_initialize("bench", CLASS)
+                 for i in range(rounds)]
+        return {"best_ms": min(times) * 1000,
+                "mean_ms": sum(times) / rounds * 1000}
+
+    result = {"rounds": rounds}
+    result["parsed"] = measure()
+    events_tcltk.set_resource_cache(os.path.join(directory, "cache"))
+    result["cold_ms"] = events_tcltk.display_initialize("bench", CLASS) * 1000
+    result["cached"] = measure()
+    result["statistics"] = events_tcltk.resource_cache_statistics()
+    print(json.dumps(result), flush=True)
+    os._exit(0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--display",
+                        help="use this X display instead of starting Xvfb")
+    parser.add_argument("--output", help="write the JSON results to a file")
+    parser.add_argument("--rounds", type=int, default=50)
+    parser.add_argument("--resources", type=int, default=5000,
+                        help="number of generated app-defaults entries")
+    parser.add_argument("--child", metavar="DIRECTORY",
+                        help=argparse.SUPPRESS)
+    args = parser.parse_args()
+    if args.child:
+        run_child(args.rounds, args.child)
+    process = None
+    environment = dict(os.environ)
+    if args.display:
+        environment["DISPLAY"] = args.display
+    else:
+        process, environment["DISPLAY"] = start_xvfb()
+    try:
+        with tempfile.TemporaryDirectory() as directory:
+            write_defaults(directory, args.resources)
+            environment["XUSERFILESEARCHPATH"] = os.path.join(directory, "%N")
+            environment["XFILESEARCHPATH"] = os.path.join(directory, "%T",
+                                                          "%N")
+            command = [sys.executable, __file__, "--child", directory,
+                       "--rounds", str(args.rounds)]
+            output = subprocess.run(command, env=environment,
+                                    capture_output=True, text=True,
+                                    timeout=300)
+    finally:
+        if process is not None:
+            process.terminate()
+            process.wait()
+    lines = output.stdout.strip().splitlines()
+    try:
+        result = json.loads(lines[-1])
+    except (IndexError, ValueError):
+        result = {"error": output.stderr.strip()}
+    text = json.dumps({"display": environment["DISPLAY"],
+                       "resources": args.resources,
+                       "startup": result}, indent=2)
+    if args.output:
+        with open(args.output, "w") as stream:
+            stream.write(text + "\n")
+    else:
+        print(text)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+"""Time creating rows of managed children with XtCreateManagedWidgets.
+
+Each round makes a fresh Composite row in the container of simple(), and
+fills it with a grid of Core cells: once with a single
+create_managed_widgets call for the whole grid, which fetches the shared
+resources once, and once with a call per cell, as XtCreateManagedWidget
+would. The cells get colors and border widths from a resource file named
+through XENVIRONMENT, so each fetch goes to the database and converts.
+This runs on an Xvfb display, unless --display is given. The best and
+mean times of each are written as JSON.
+
+    python Tests/benchmark_widgets.py --output widgets.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+from benchmark_notifier import start_xvfb
+
+
+RESOURCES = """\
+*row.cell.background: #d9d9d9
+*row.cell.borderColor: #202020
+*row.cell.borderWidth: 1
+*row.cell.mappedWhenManaged: true
+"""
+
+
+def run_child(rounds, columns, rows):
+    import tkinter
+    from guitk import events_tcltk
+    window = tkinter.Tk()
+    container = events_tcltk.simple(window.tk.interpaddr())
+    shared = {"width": 20, "height": 20}
+    names = ["x", "y"]
+    items = [(20 * column, 20 * row)
+             for row in range(rows) for column in range(columns)]
+
+    def new_row():
+        [row] = events_tcltk.create_managed_widgets(
+            container, "row", {"width": 20 * columns, "height": 20 * rows},
+            [], [()], True)
+        return row
+
+    def bulk():
+        row = new_row()
+        start = time.perf_counter()
+        events_tcltk.create_managed_widgets(row, "cell", shared, names, items)
+        return time.perf_counter() - start
+
+    def single():
+        row = new_row()
+        start = time.perf_counter()
+        for item in items:
+            events_tcltk.create_managed_widgets(row, "cell", shared, names,
+                                                [item])
+        return time.perf_counter() - start
+
+    bulk()
+    single()                            # fill the converter caches
+    result = {"rounds": rounds, "children": len(items)}
+    for label, measure in (("bulk", bulk), ("single", single)):
+        times = [measure() for i in range(rounds)]
+        result[label] = {"best_ms": min(times) * 1000,
+                         "mean_ms": sum(times) / rounds * 1000}
+    print(json.dumps(result), flush=True)
+    os._exit(0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--display",
+                        help="use this X display instead of starting Xvfb")
+    parser.add_argument("--output", help="write the JSON results to a file")
+    parser.add_argument("--rounds", type=int, default=20)
+    parser.add_argument("--columns", type=int, default=20)
+    parser.add_argument("--rows", type=int, default=50)
+    parser.add_argument("--child", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+    if args.child:
+        run_child(args.rounds, args.columns, args.rows)
+    process = None
+    environment = dict(os.environ)
+    if args.display:
+        environment["DISPLAY"] = args.display
+    else:
+        process, environment["DISPLAY"] = start_xvfb()
+    try:
+        with tempfile.NamedTemporaryFile("w", suffix=".ad") as stream:
+            stream.write(RESOURCES)
+            stream.flush()
+            environment["XENVIRONMENT"] = stream.name
+            command = [sys.executable, __file__, "--child",
+                       "--rounds", str(args.rounds),
+                       "--columns", str(args.columns),
+                       "--rows", str(args.rows)]
+            output = subprocess.run(command, env=environment,
+                                    capture_output=True, text=True,
+                                    timeout=300)
+    finally:
+        if process is not None:
+            process.terminate()
+            process.wait()
+    lines = output.stdout.strip().splitlines()
+    try:
+        result = json.loads(lines[-1])
+    except (IndexError, ValueError):
+        result = {"error": output.stderr.strip()}
+    text = json.dumps({"display": environment["DISPLAY"],
+                       "widgets": result}, indent=2)
+    if args.output:
+        with open(args.output, "w") as stream:
+            stream.write(text + "\n")
+    else:
+        print(text)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+"""Check that the last value set inside a SetValues transaction wins.
+
+A Core widget is created in the container made by simple(). Its width is
+set and then set back to the original inside one transaction, which
+should leave its geometry alone at commit; then it is set twice, and the
+second value should be the one applied. This runs on an Xvfb display,
+unless --display is given.
+
+    python Tests/test_set_values.py
+"""
+
+import argparse
+import os
+
+from benchmark_notifier import start_xvfb
+
+
+def check():
+    import tkinter
+    from guitk import events_tcltk
+    window = tkinter.Tk()
+    container = events_tcltk.simple(window.tk.interpaddr())
+    [widget] = events_tcltk.create_managed_widgets(
+        container, "probe", {"width": 50, "height": 50}, ["y"], [(0,)])
+    x, y, width, height, border_width = original = \
+        events_tcltk.widget_geometry(widget)
+
+    events_tcltk.begin_set_values_transaction()
+    events_tcltk.set_values([widget], ["width"], [(width + 70,)])
+    events_tcltk.set_values([widget], ["width"], [(width,)])
+    events_tcltk.commit_set_values_transaction()
+    geometry = events_tcltk.widget_geometry(widget)
+    assert geometry == original, "set back: %s, expected %s" % (geometry,
+                                                                original)
+
+    events_tcltk.begin_set_values_transaction()
+    events_tcltk.set_values([widget], ["width"], [(width + 70,)])
+    events_tcltk.set_values([widget], ["width", "height"],
+                            [(width + 30, height + 20)])
+    events_tcltk.commit_set_values_transaction()
+    geometry = events_tcltk.widget_geometry(widget)
+    expected = (x, y, width + 30, height + 20, border_width)
+    assert geometry == expected, "set twice: %s, expected %s" % (geometry,
+                                                                 expected)
+    print("ok")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--display",
+                        help="use this X display instead of starting Xvfb")
+    args = parser.parse_args()
+    process = None
+    if args.display:
+        os.environ["DISPLAY"] = args.display
+    else:
+        process, os.environ["DISPLAY"] = start_xvfb()
+    try:
+        check()
+    finally:
+        if process is not None:
+            process.terminate()
+            process.wait()
+
+
+if __name__ == "__main__":
+    main()
@@ -295,3 +295,297 @@ _XtHeapFree(Heap *heap)
     heap->start = NULL;
     heap->bytes_remaining = 0;
 }
+
+/*
+ * Shell arenas.  While they are enabled, the record of each widget created
+ * under a shell is carved out of large chunks owned by the nearest shell
+ * ancestor, and the chunks are freed together when that shell is
+ * destroyed.  A record whose widget is destroyed before its shell goes on
+ * a free list of the arena for its size, and is handed out again to the
+ * next widget of that size created under the shell, so that a long-lived
+ * shell whose children come and go does not keep growing its arena.  Each
+ * record is preceded by an entry in a hash table keyed by the widget, so
+ * that destroying a widget can tell whether its record came from an
+ * arena; the entry of the shell owning an arena is kept in the arena
+ * record itself.
+ */
+
+#ifndef ARENA_CHUNK_SIZE
+#define ARENA_CHUNK_SIZE 16384
+#endif
+
+#define ARENA_ALIGN sizeof(union { long l; double d; XtPointer p; })
+#define ARENA_ROUND(bytes) \
+    (((bytes) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+#define ARENA_FREE_LISTS 16
+#define ARENA_FREE_LIST(size) (((size) / ARENA_ALIGN) & (ARENA_FREE_LISTS - 1))
+
+typedef struct _ArenaEntryRec {
+    struct _ArenaEntryRec *next;
+    Widget widget;
+    struct _ArenaRec *arena;
+    Cardinal size;              /* of the entry and its record */
+    Boolean owner;              /* widget is the shell owning arena */
+} ArenaEntryRec, *ArenaEntry;
+
+typedef struct _ArenaRec {
+    ArenaEntryRec entry;        /* keyed by the owning shell */
+    ArenaEntry free[ARENA_FREE_LISTS];  /* released records, by size */
+    char *chunks;               /* chained through their first word */
+    char *current;
+    Cardinal bytes_remaining;
+    Cardinal records;           /* records of live widgets */
+    unsigned long bytes;        /* size of all its chunks */
+} ArenaRec, *Arena;
+
+static struct {
+    ArenaEntry *buckets;
+    Cardinal size;              /* a power of two */
+    Cardinal count;
+    Boolean enabled;
+    Cardinal arenas;
+    unsigned long bytes;
+    unsigned long records;
+} arenaTable;
+
+#define ARENA_HASH(widget, size) \
+    ((Cardinal) (((unsigned long) (widget) >> 4) & ((size) - 1)))
+
+void _XtSetShellArenas(Boolean);
+XtPointer _XtArenaAlloc(Widget, Cardinal);
+Boolean _XtArenaRelease(Widget);
+void _XtGetArenaStatistics(unsigned long *, unsigned long *, unsigned long *);
+
+static void
+EnterArenaEntry(ArenaEntry entry)
+{
+    ArenaEntry *buckets, e;
+    Cardinal i, j, size;
+
+    if (arenaTable.count >= arenaTable.size) {
+        size = arenaTable.size ? arenaTable.size << 1 : 256;
+        buckets = (ArenaEntry *) __XtCalloc(size, (Cardinal) sizeof(ArenaEntry));
+        for (i = 0; i < arenaTable.size; i++) {
+            while ((e = arenaTable.buckets[i])) {
+                arenaTable.buckets[i] = e->next;
+                j = ARENA_HASH(e->widget, size);
+                e->next = buckets[j];
+                buckets[j] = e;
+            }
+        }
+        XtFree((char *) arenaTable.buckets);
+        arenaTable.buckets = buckets;
+        arenaTable.size = size;
+    }
+    i = ARENA_HASH(entry->widget, arenaTable.size);
+    entry->next = arenaTable.buckets[i];
+    arenaTable.buckets[i] = entry;
+    arenaTable.count++;
+}
+
+/* Remove and return the entry for widget of the given kind, if any */
+static ArenaEntry
+RemoveArenaEntry(Widget widget, Boolean owner)
+{
+    ArenaEntry *prev, entry;
+
+    if (!arenaTable.count)
+        return NULL;
+    for (prev = &arenaTable.buckets[ARENA_HASH(widget, arenaTable.size)];
+         (entry = *prev); prev = &entry->next) {
+        if (entry->widget == widget && entry->owner == owner) {
+            *prev = entry->next;
+            arenaTable.count--;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static Arena
+FindArena(Widget shell)
+{
+    ArenaEntry entry;
+
+    if (!arenaTable.count)
+        return NULL;
+    for (entry = arenaTable.buckets[ARENA_HASH(shell, arenaTable.size)];
+         entry; entry = entry->next)
+        if (entry->widget == shell && entry->owner)
+            return entry->arena;
+    return NULL;
+}
+
+/*
+ * Start or stop giving new shells an arena.  Shells that already have
+ * one keep using it.
+ */
+void
+_XtSetShellArenas(Boolean enable)
+{
+    LOCK_PROCESS;
+    arenaTable.enabled = enable;
+    UNLOCK_PROCESS;
+}
+
+/*
+ * Return zeroed memory for the record of a new child of parent from the
+ * arena of the nearest shell, or NULL if that shell has no arena.
+ */
+XtPointer
+_XtArenaAlloc(Widget parent, Cardinal bytes)
+{
+    Widget shell;
+    Arena arena;
+    ArenaEntry entry, *prev;
+    Cardinal size;
+    char *chunk;
+
+    for (shell = parent; shell && !XtIsShell(shell); shell = XtParent(shell));
+    if (!shell)
+        return NULL;
+    LOCK_PROCESS;
+    if (!(arena = FindArena(shell))) {
+        if (!arenaTable.enabled) {
+            UNLOCK_PROCESS;
+            return NULL;
+        }
+        arena = XtNew(ArenaRec);
+        arena->entry.widget = shell;
+        arena->entry.arena = arena;
+        arena->entry.owner = True;
+        arena->chunks = arena->current = NULL;
+        (void) memset(arena->free, 0, sizeof(arena->free));
+        arena->bytes_remaining = 0;
+        arena->records = 0;
+        arena->bytes = 0;
+        EnterArenaEntry(&arena->entry);
+        arenaTable.arenas++;
+    }
+    size = (Cardinal) (ARENA_ROUND(sizeof(ArenaEntryRec)) + ARENA_ROUND(bytes));
+    for (prev = &arena->free[ARENA_FREE_LIST(size)]; (entry = *prev);
+         prev = &entry->next) {
+        if (entry->size == size) {
+            *prev = entry->next;
+            goto enter;
+        }
+    }
+    if (size > arena->bytes_remaining) {
+        Cardinal header = (Cardinal) ARENA_ROUND(sizeof(char *));
+
+        if (size > ARENA_CHUNK_SIZE / 4) {
+            /* keep the current chunk; chain this one behind it */
+            chunk = XtMalloc(header + size);
+            if (arena->chunks) {
+                *(char **) chunk = *(char **) arena->chunks;
+                *(char **) arena->chunks = chunk;
+            }
+            else {
+                *(char **) chunk = NULL;
+                arena->chunks = chunk;
+            }
+            arena->bytes += header + size;
+            arenaTable.bytes += header + size;
+            entry = (ArenaEntry) (chunk + header);
+            goto enter;
+        }
+        chunk = XtMalloc(ARENA_CHUNK_SIZE);
+        *(char **) chunk = arena->chunks;
+        arena->chunks = chunk;
+        arena->current = chunk + header;
+        arena->bytes_remaining = ARENA_CHUNK_SIZE - header;
+        arena->bytes += ARENA_CHUNK_SIZE;
+        arenaTable.bytes += ARENA_CHUNK_SIZE;
+    }
+    entry = (ArenaEntry) arena->current;
+    arena->current += size;
+    arena->bytes_remaining -= size;
+ enter:
+    chunk = (char *) entry + ARENA_ROUND(sizeof(ArenaEntryRec));
+    (void) memset(chunk, 0, bytes);
+    entry->widget = (Widget) chunk;
+    entry->arena = arena;
+    entry->size = size;
+    entry->owner = False;
+    EnterArenaEntry(entry);
+    arena->records++;
+    arenaTable.records++;
+    UNLOCK_PROCESS;
+    return (XtPointer) chunk;
+}
+
+/*
+ * Called when the record of widget is about to be freed.  If widget owns
+ * an arena, free all of it.  Returns True if the record itself came from
+ * an arena, in which case it must not be passed to XtFree.
+ */
+Boolean
+_XtArenaRelease(Widget widget)
+{
+    ArenaEntry entry;
+    Boolean in_arena = False;
+
+    LOCK_PROCESS;
+    if ((entry = RemoveArenaEntry(widget, False))) {
+        Arena arena = entry->arena;
+        ArenaEntry *list = &arena->free[ARENA_FREE_LIST(entry->size)];
+
+        /* the record itself is left alone until it is handed out again */
+        entry->widget = NULL;
+        entry->next = *list;
+        *list = entry;
+        arena->records--;
+        arenaTable.records--;
+        in_arena = True;
+    }
+    if ((entry = RemoveArenaEntry(widget, True))) {
+        Arena arena = entry->arena;
+        char *chunk = arena->chunks;
+
+        if (arena->records) {
+            /* records of widgets that outlive their shell */
+            ArenaEntry *prev, e;
+            Cardinal i;
+
+            for (i = 0; i < arenaTable.size; i++) {
+                for (prev = &arenaTable.buckets[i]; (e = *prev);) {
+                    if (e->arena == arena) {
+                        *prev = e->next;
+                        arenaTable.count--;
+                    }
+                    else
+                        prev = &e->next;
+                }
+            }
+            arenaTable.records -= arena->records;
+        }
+        while (chunk) {
+            char *next = *(char **) chunk;
+
+            XtFree(chunk);
+            chunk = next;
+        }
+        arenaTable.bytes -= arena->bytes;
+        arenaTable.arenas--;
+        XtFree((char *) arena);
+    }
+    UNLOCK_PROCESS;
+    return in_arena;
+}
+
+/*
+ * Return the number of shells with an arena, the total size of their
+ * chunks, and the number of live widget records they hold.
+ */
+void
+_XtGetArenaStatistics(unsigned long *arenas,
+                      unsigned long *bytes,
+                      unsigned long *records)
+{
+    LOCK_PROCESS;
+    *arenas = arenaTable.arenas;
+    *bytes = arenaTable.bytes;
+    *records = arenaTable.records;
+    UNLOCK_PROCESS;
+}
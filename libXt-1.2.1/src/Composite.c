@@ -74,6 +74,9 @@ in this Software without prior written authorization from The Open Group.
 #include "IntrinsicI.h"
 #include "StringDefs.h"
 
+extern void _XtFlushNameIndex(Widget);      /* from Intrinsic.c */
+extern void _XtIndexChildDeleted(Widget);   /* from Intrinsic.c */
+
 static XtResource resources[] = {
     {XtNchildren, XtCReadOnly, XtRWidgetList, sizeof(WidgetList),
      XtOffsetOf(CompositeRec, composite.children), XtRImmediate, NULL},
@@ -224,6 +227,7 @@ CompositeDestroy(Widget w)
 {
     register CompositeWidget cw = (CompositeWidget) w;
 
+    _XtFlushNameIndex(w);
     XtFree((char *) cw->composite.children);
 }
 
@@ -284,6 +288,68 @@ CompositeDeleteChild(Widget w)
     }
 }
 
+/*
+ * Detach a batch of siblings that are destroyed together: one
+ * XtUnmanageChildren, and one pass over the children array when the
+ * parent uses the Composite delete_child.  The batch is marked through
+ * being_destroyed, which is already set for every widget in it.
+ */
+void
+_XtDeleteChildren(Widget parent, WidgetList children, Cardinal num_children)
+{
+    CompositeWidget cw = (CompositeWidget) parent;
+    XtWidgetProc delete_child;
+    Cardinal i, j, num_rect = 0;
+
+    _XtIndexChildDeleted(children[0]);
+    for (i = 0; i < num_children; i++)
+        if (XtIsRectObj(children[i]))
+            num_rect++;
+    if (num_rect == num_children)
+        XtUnmanageChildren(children, num_children);
+    else
+        for (i = 0; i < num_children; i++)
+            if (XtIsRectObj(children[i]))
+                XtUnmanageChild(children[i]);
+
+    LOCK_PROCESS;
+    delete_child =
+        ((CompositeWidgetClass) parent->core.widget_class)->composite_class.
+        delete_child;
+    UNLOCK_PROCESS;
+    if (delete_child == NULL) {
+        String param;
+        Cardinal num_params = 1;
+
+        LOCK_PROCESS;
+        param = parent->core.widget_class->core_class.class_name;
+        UNLOCK_PROCESS;
+        XtAppWarningMsg(XtWidgetToApplicationContext(parent),
+                        "invalidProcedure", "deleteChild",
+                        XtCXtToolkitError,
+                        "null delete_child procedure for class %s in XtDestroy",
+                        &param, &num_params);
+        return;
+    }
+    if (delete_child != CompositeDeleteChild) {
+        for (i = 0; i < num_children; i++)
+            (*delete_child) (children[i]);
+        return;
+    }
+
+    for (i = 0; i < num_children; i++)
+        children[i]->core.being_destroyed = 2;
+    for (i = j = 0; i < cw->composite.num_children; i++) {
+        Widget child = cw->composite.children[i];
+
+        if (child->core.being_destroyed == 2)
+            child->core.being_destroyed = TRUE;
+        else
+            cw->composite.children[j++] = child;
+    }
+    cw->composite.num_children = j;
+}
+
 static void
 CompositeInitialize(Widget requested_widget _X_UNUSED,
                     Widget new_widget,
@@ -80,7 +80,6 @@ in this Software without prior written authorization from The Open Group.
 #define CONVERTHASHSIZE ((unsigned)256)
 #define CONVERTHASHMASK 255
 #define ProcHash(from_type, to_type) (2 * (from_type) + to_type)
-#define HashCode(converter, from) (int)(((long)(converter) >> 2) + from->size + *((char *) from->addr))
 
 typedef struct _ConverterRec *ConverterPtr;
 typedef struct _ConverterRec {
@@ -154,9 +153,10 @@ _XtFreeConverterTable(ConverterTable table)
 typedef struct _CacheRec *CachePtr;
 
 typedef struct _CacheRec {
-    CachePtr next;
+    CachePtr lru_next;          /* evictable entries only */
+    CachePtr lru_prev;
     XtPointer tag;
-    int hash;
+    unsigned int hash;
     XtTypeConverter converter;
     unsigned short num_args;
     unsigned int conversion_succeeded:1;
@@ -165,12 +165,12 @@ typedef struct _CacheRec {
     unsigned int must_be_freed:1;
     unsigned int from_is_value:1;
     unsigned int to_is_value:1;
+    unsigned int evictable:1;
     XrmValue from;
     XrmValue to;
 } CacheRec;
 
 typedef struct _CacheRecExt {
-    CachePtr *prev;
     XtDestructor destructor;
     XtPointer closure;
     long ref_count;
@@ -179,11 +179,39 @@ typedef struct _CacheRecExt {
 #define CEXT(p) ((CacheRecExt *)((p)+1))
 #define CARGS(p) ((p)->has_ext ? (XrmValue *)(CEXT(p)+1) : (XrmValue *)((p)+1))
 
-#define CACHEHASHSIZE   256
-#define CACHEHASHMASK   255
-typedef CachePtr CacheHashTable[CACHEHASHSIZE];
-
-static CacheHashTable cacheHashTable;
+/*
+ * The conversion cache is an open addressing table with linear probing,
+ * keyed by a hash of the converter, the whole source value and all the
+ * conversion arguments.  It is kept at most half full.
+ *
+ * When a memory limit is set, new XtCacheAll entries without a
+ * destructor or reference count are allocated individually instead of
+ * on a heap, and are kept on a list in order of use.  The least recently
+ * used of them are evicted when their total size exceeds the limit.  An
+ * entry returned to an old-style caller, which keeps a pointer into it,
+ * is no longer evictable.
+ */
+#define CACHE_INITIAL_SIZE 256
+
+static struct {
+    CachePtr *slots;
+    Cardinal size;              /* a power of two */
+    Cardinal count;
+    CachePtr lru_head;          /* most recently used evictable entry */
+    CachePtr lru_tail;
+    unsigned long bytes;        /* size of the evictable entries */
+    unsigned long limit;        /* 0 if unbounded */
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} convertCache;
+
+static void FreeCacheRec(XtAppContext, CachePtr);
+
+void _XtSetConverterCacheLimit(unsigned long);
+void _XtGetConverterCacheStatistics(unsigned long *, unsigned long *,
+                                    unsigned long *, unsigned long *,
+                                    unsigned long *);
 
 void
 _XtTableAddConverter(ConverterTable table,
@@ -345,6 +373,187 @@ XtAppAddConverter(XtAppContext app,
     UNLOCK_PROCESS;
 }
 
+#define HASH_BYTES(hash, addr, size) \
+    { \
+        register const unsigned char *b = (const unsigned char *) (addr); \
+        register Cardinal n = (size); \
+        while (n--) \
+            hash = (hash ^ *b++) * 16777619U; \
+    }
+
+static unsigned int
+CacheHash(XtPointer converter,
+          XrmValuePtr args,
+          Cardinal num_args,
+          XrmValuePtr from)
+{
+    unsigned int hash = 2166136261U;
+    Cardinal i;
+
+    hash = (hash ^ (unsigned int) ((unsigned long) converter >> 2)) *
+        16777619U;
+    hash = (hash ^ from->size) * 16777619U;
+    HASH_BYTES(hash, from->addr, from->size);
+    for (i = 0; i < num_args; i++) {
+        hash = (hash ^ args[i].size) * 16777619U;
+        HASH_BYTES(hash, args[i].addr, args[i].size);
+    }
+    return hash ^ (hash >> 16);
+}
+
+static unsigned long
+CacheRecSize(CachePtr p)
+{
+    unsigned long size;
+    Cardinal i;
+
+    size = sizeof(CacheRec) + p->num_args * sizeof(XrmValue);
+    if (p->has_ext)
+        size += sizeof(CacheRecExt);
+    if (!p->from_is_value)
+        size += p->from.size;
+    if (!p->to_is_value && p->to.addr)
+        size += p->to.size;
+    for (i = 0; i < p->num_args; i++)
+        size += CARGS(p)[i].size;
+    return size;
+}
+
+static void
+CacheInsert(CachePtr p)
+{
+    register Cardinal i, mask;
+
+    mask = convertCache.size - 1;
+    for (i = p->hash & mask; convertCache.slots[i]; i = (i + 1) & mask);
+    convertCache.slots[i] = p;
+    convertCache.count++;
+}
+
+static void
+ExpandCache(void)
+{
+    CachePtr *slots = convertCache.slots;
+    Cardinal size = convertCache.size;
+    Cardinal i;
+
+    convertCache.size = size ? size << 1 : CACHE_INITIAL_SIZE;
+    convertCache.slots = (CachePtr *)
+        __XtCalloc(convertCache.size, (Cardinal) sizeof(CachePtr));
+    convertCache.count = 0;
+    for (i = 0; i < size; i++)
+        if (slots[i])
+            CacheInsert(slots[i]);
+    XtFree((char *) slots);
+}
+
+/* Take p out of the table, shifting back the entries probed past it */
+static void
+CacheRemove(CachePtr p)
+{
+    register Cardinal i, j, home, mask;
+
+    mask = convertCache.size - 1;
+    for (i = p->hash & mask; convertCache.slots[i] != p; i = (i + 1) & mask);
+    convertCache.slots[i] = NULL;
+    for (j = (i + 1) & mask; convertCache.slots[j]; j = (j + 1) & mask) {
+        home = convertCache.slots[j]->hash & mask;
+        if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+            convertCache.slots[i] = convertCache.slots[j];
+            convertCache.slots[j] = NULL;
+            i = j;
+        }
+    }
+    convertCache.count--;
+}
+
+static void
+LRUUnlink(CachePtr p)
+{
+    if (p->lru_prev)
+        p->lru_prev->lru_next = p->lru_next;
+    else
+        convertCache.lru_head = p->lru_next;
+    if (p->lru_next)
+        p->lru_next->lru_prev = p->lru_prev;
+    else
+        convertCache.lru_tail = p->lru_prev;
+}
+
+static void
+LRULinkFirst(CachePtr p)
+{
+    p->lru_prev = NULL;
+    p->lru_next = convertCache.lru_head;
+    if (p->lru_next)
+        p->lru_next->lru_prev = p;
+    else
+        convertCache.lru_tail = p;
+    convertCache.lru_head = p;
+}
+
+/* A pointer into p has been handed out; it must stay in the cache */
+static void
+CachePin(CachePtr p)
+{
+    if (p->evictable) {
+        LRUUnlink(p);
+        convertCache.bytes -= CacheRecSize(p);
+        p->evictable = False;
+    }
+}
+
+static CachePtr
+CacheLookup(XtTypeConverter converter,
+            XrmValuePtr args,
+            Cardinal num_args,
+            XrmValuePtr from,
+            unsigned int hash)
+{
+    register CachePtr p;
+    register Cardinal i, mask;
+
+    mask = convertCache.size - 1;
+    for (i = hash & mask; convertCache.size && (p = convertCache.slots[i]);
+         i = (i + 1) & mask) {
+        if ((p->hash == hash)
+            && (p->converter == converter)
+            && (p->from.size == from->size)
+            && !(p->from_is_value ?
+                 XtMemcmp(&p->from.addr, from->addr, from->size) :
+                 memcmp((const void *) p->from.addr, (const void *) from->addr,
+                        from->size))
+            && (p->num_args == num_args)) {
+            Cardinal j;
+
+            if ((j = num_args)) {
+                XrmValue *pargs = CARGS(p);
+
+                /* Are all args the same data ? */
+                while (j) {
+                    j--;        /* do not move to while test, broken compilers */
+                    if (pargs[j].size != args[j].size ||
+                        XtMemcmp(pargs[j].addr, args[j].addr, args[j].size)) {
+                        j++;
+                        break;
+                    }
+                }
+            }
+            if (!j) {
+                /* Perfect match */
+                if (p->evictable && p != convertCache.lru_head) {
+                    LRUUnlink(p);
+                    LRULinkFirst(p);
+                }
+                convertCache.hits++;
+                return p;
+            }
+        }
+    }
+    convertCache.misses++;
+    return NULL;
+}
+
 static CachePtr
 CacheEnter(Heap *heap,
            register XtTypeConverter converter,
@@ -353,24 +562,30 @@ CacheEnter(Heap *heap,
            XrmValuePtr from,
            XrmValuePtr to,
            Boolean succeeded,
-           register int hash,
+           unsigned int hash,
            Boolean do_ref,
            Boolean do_free,
+           Boolean evictable,
            XtDestructor destructor,
            XtPointer closure)
 {
-    register CachePtr *pHashEntry;
     register CachePtr p;
+    Heap *tag = heap;
 
     LOCK_PROCESS;
-    pHashEntry = &cacheHashTable[hash & CACHEHASHMASK];
-
+    evictable = evictable && convertCache.limit && !do_ref &&
+        !(succeeded && destructor);
+    if (evictable) {
+        /* allocated individually so that it can be evicted */
+        evictable = True;
+        do_free = True;
+        heap = NULL;
+    }
     if ((succeeded && destructor) || do_ref) {
         p = (CachePtr) _XtHeapAlloc(heap, (Cardinal) (sizeof(CacheRec) +
                                                       sizeof(CacheRecExt) +
                                                       num_args *
                                                       sizeof(XrmValue)));
-        CEXT(p)->prev = pHashEntry;
         CEXT(p)->destructor = succeeded ? destructor : NULL;
         CEXT(p)->closure = closure;
         CEXT(p)->ref_count = 1;
@@ -387,12 +602,8 @@ CacheEnter(Heap *heap,
     XtSetBit(p->conversion_succeeded, succeeded);
     XtSetBit(p->is_refcounted, do_ref);
     XtSetBit(p->must_be_freed, do_free);
-    p->next = *pHashEntry;
-    if (p->next && p->next->has_ext)
-        CEXT(p->next)->prev = &p->next;
-
-    *pHashEntry = p;
-    p->tag = (XtPointer) heap;
+    p->evictable = False;
+    p->tag = (XtPointer) tag;
     p->hash = hash;
     p->converter = converter;
     p->from.size = from->size;
@@ -430,14 +641,36 @@ CacheEnter(Heap *heap,
         p->to.addr = (XPointer) _XtHeapAlloc(heap, to->size);
         (void) memmove((char *) p->to.addr, (char *) to->addr, to->size);
     }
+
+    if ((convertCache.count + 1) * 2 > convertCache.size)
+        ExpandCache();
+    CacheInsert(p);
+    if (evictable) {
+        p->evictable = True;
+        LRULinkFirst(p);
+        convertCache.bytes += CacheRecSize(p);
+        while (convertCache.bytes > convertCache.limit &&
+               convertCache.lru_tail != p) {
+            CachePtr victim = convertCache.lru_tail;
+
+            CacheRemove(victim);
+            FreeCacheRec(NULL, victim);
+            convertCache.evictions++;
+        }
+    }
     UNLOCK_PROCESS;
     return p;
 }
 
+/* Free p, which the caller has already taken out of the table */
 static void
-FreeCacheRec(XtAppContext app, CachePtr p, CachePtr * prev)
+FreeCacheRec(XtAppContext app, CachePtr p)
 {
     LOCK_PROCESS;
+    if (p->evictable) {
+        LRUUnlink(p);
+        convertCache.bytes -= CacheRecSize(p);
+    }
     if (p->has_ext) {
         if (CEXT(p)->destructor) {
             Cardinal num_args = p->num_args;
@@ -454,14 +687,6 @@ FreeCacheRec(XtAppContext app, CachePtr p, CachePtr * prev)
             (*CEXT(p)->destructor) (app, &toc, CEXT(p)->closure, args,
                                     &num_args);
         }
-        *(CEXT(p)->prev) = p->next;
-        if (p->next && p->next->has_ext)
-            CEXT(p->next)->prev = CEXT(p)->prev;
-    }
-    else if (prev) {
-        *prev = p->next;
-        if (p->next && p->next->has_ext)
-            CEXT(p->next)->prev = prev;
     }
     if (p->must_be_freed) {
         register int i;
@@ -485,20 +710,68 @@ FreeCacheRec(XtAppContext app, CachePtr p, CachePtr * prev)
 void
 _XtCacheFlushTag(XtAppContext app, XtPointer tag)
 {
-    int i;
+    CachePtr *slots;
+    Cardinal i, size;
     register CachePtr rec;
 
     LOCK_PROCESS;
-    for (i = CACHEHASHSIZE; --i >= 0;) {
-        register CachePtr *prev = &cacheHashTable[i];
-
-        while ((rec = *prev)) {
+    /* Free the entries with this tag and rehash the others */
+    slots = convertCache.slots;
+    size = convertCache.size;
+    convertCache.slots = (CachePtr *)
+        __XtCalloc(size, (Cardinal) sizeof(CachePtr));
+    convertCache.count = 0;
+    for (i = 0; i < size; i++) {
+        if ((rec = slots[i])) {
             if (rec->tag == tag)
-                FreeCacheRec(app, rec, prev);
+                FreeCacheRec(app, rec);
             else
-                prev = &rec->next;
+                CacheInsert(rec);
         }
     }
+    XtFree((char *) slots);
+    UNLOCK_PROCESS;
+}
+
+/*
+ * Bound the total size of the evictable conversion cache entries to
+ * limit bytes, or remove the bound if limit is 0.  Only entries made
+ * while a bound is set can be evicted.
+ */
+void
+_XtSetConverterCacheLimit(unsigned long limit)
+{
+    CachePtr victim;
+
+    LOCK_PROCESS;
+    convertCache.limit = limit;
+    while (limit && convertCache.bytes > limit &&
+           (victim = convertCache.lru_tail)) {
+        CacheRemove(victim);
+        FreeCacheRec(NULL, victim);
+        convertCache.evictions++;
+    }
+    UNLOCK_PROCESS;
+}
+
+/*
+ * Return the number of conversions found in and missing from the cache,
+ * the number of entries evicted, the number of entries in the cache,
+ * and the total size of the evictable entries.
+ */
+void
+_XtGetConverterCacheStatistics(unsigned long *hits,
+                               unsigned long *misses,
+                               unsigned long *evictions,
+                               unsigned long *entries,
+                               unsigned long *bytes)
+{
+    LOCK_PROCESS;
+    *hits = convertCache.hits;
+    *misses = convertCache.misses;
+    *evictions = convertCache.evictions;
+    *entries = convertCache.count;
+    *bytes = convertCache.bytes;
     UNLOCK_PROCESS;
 }
 
@@ -508,27 +781,28 @@ _XtCacheFlushTag(XtAppContext app, XtPointer tag)
 void
 _XtConverterCacheStats(void)
 {
-    register Cardinal i;
+    register Cardinal i, j;
     register CachePtr p;
-    register Cardinal entries;
+    Cardinal probes, longest = 0;
 
     LOCK_PROCESS;
-    for (i = 0; i < CACHEHASHSIZE; i++) {
-        p = cacheHashTable[i];
+    (void) fprintf(stdout, "Slots: %d  Entries: %d  Evictable bytes: %lu\n",
+                   convertCache.size, convertCache.count, convertCache.bytes);
+    for (i = 0; i < convertCache.size; i++) {
+        p = convertCache.slots[i];
         if (p) {
-            for (entries = 0; p; p = p->next) {
-                entries++;
-            }
-            (void) fprintf(stdout, "Index: %4d  Entries: %d\n", i, entries);
-            for (p = cacheHashTable[i]; p; p = p->next) {
-                (void) fprintf(stdout, "    Size: %3d  Refs: %3ld  '",
-                               p->from.size,
-                               p->has_ext ? CEXT(p)->ref_count : 0);
-                (void) fprintf(stdout, "'\n");
-            }
-            (void) fprintf(stdout, "\n");
+            for (j = p->hash, probes = 1;
+                 (j & (convertCache.size - 1)) != i; j++)
+                probes++;
+            if (probes > longest)
+                longest = probes;
+            (void) fprintf(stdout,
+                           "Index: %4d  Probes: %d  Size: %3d  Refs: %3ld\n",
+                           i, probes, p->from.size,
+                           p->has_ext ? CEXT(p)->ref_count : 0);
         }
     }
+    (void) fprintf(stdout, "Longest probe sequence: %d\n", longest);
     UNLOCK_PROCESS;
 }
 #endif /*DEBUG*/
@@ -649,48 +923,20 @@ XtDirectConvert(XtConverter converter,
                 XrmValuePtr to)
 {
     register CachePtr p;
-    register int hash;
-    register Cardinal i;
+    unsigned int hash;
 
     LOCK_PROCESS;
     /* Try to find cache entry for conversion */
-    hash = HashCode(converter, from);
-    if (from->size > 1)
-        hash += ((char *) from->addr)[1];
-
-    for (p = cacheHashTable[hash & CACHEHASHMASK]; p; p = p->next) {
-        if ((p->hash == hash)
-            && (p->converter == (XtTypeConverter) converter)
-            && (p->from.size == from->size)
-            && !(p->from_is_value ?
-                 XtMemcmp(&p->from.addr, from->addr, from->size) :
-                 memcmp((const void *) p->from.addr, (const void *) from->addr,
-                        from->size))
-            && (p->num_args == num_args)) {
-            if ((i = num_args)) {
-                XrmValue *pargs = CARGS(p);
-
-                /* Are all args the same data ? */
-                while (i) {
-                    i--;        /* do not move to while test, broken compilers */
-                    if (pargs[i].size != args[i].size ||
-                        XtMemcmp(pargs[i].addr, args[i].addr, args[i].size)) {
-                        i++;
-                        break;
-                    }
-                }
-            }
-            if (!i) {
-                /* Perfect match */
-                to->size = p->to.size;
-                if (p->to_is_value)
-                    to->addr = (XPointer) &p->to.addr;
-                else
-                    to->addr = p->to.addr;
-                UNLOCK_PROCESS;
-                return;
-            }
-        }
+    hash = CacheHash((XtPointer) converter, args, num_args, from);
+    p = CacheLookup((XtTypeConverter) converter, args, num_args, from, hash);
+    if (p) {
+        to->size = p->to.size;
+        if (p->to_is_value)
+            to->addr = (XPointer) &p->to.addr;
+        else
+            to->addr = p->to.addr;
+        UNLOCK_PROCESS;
+        return;
     }
 
     /* Didn't find it, call converter procedure and entry result in cache */
@@ -701,7 +947,7 @@ XtDirectConvert(XtConverter converter,
      * or app context from which to compute the persistance */
     {
         CacheEnter(&globalHeap, (XtTypeConverter) converter, args, num_args,
-                   from, to, (to->addr != NULL), hash, False, False,
+                   from, to, (to->addr != NULL), hash, False, False, False,
                    (XtDestructor) NULL, NULL);
     }
     UNLOCK_PROCESS;
@@ -737,7 +983,7 @@ CallConverter(Display *dpy,
               register ConverterPtr cP)
 {
     CachePtr p;
-    int hash;
+    unsigned int hash;
     Boolean retval;
 
     if (!cP || ((cP->cache_type == XtCacheNone) && !cP->destructor)) {
@@ -752,79 +998,49 @@ CallConverter(Display *dpy,
 
     LOCK_PROCESS;
     /* Try to find cache entry for conversion */
-    hash = HashCode(converter, from);
-    if (from->size > 1)
-        hash += ((char *) from->addr)[1];
-
-    if (cP->cache_type != XtCacheNone) {
-        for (p = cacheHashTable[hash & CACHEHASHMASK]; p; p = p->next) {
-            if ((p->hash == hash)
-                && (p->converter == converter)
-                && (p->from.size == from->size)
-                && !(p->from_is_value ?
-                     XtMemcmp(&p->from.addr, from->addr, from->size) :
-                     memcmp((const void *) p->from.addr,
-                            (const void *) from->addr, from->size))
-                && (p->num_args == num_args)) {
-                Cardinal i;
-
-                if ((i = num_args)) {
-                    XrmValue *pargs = CARGS(p);
-
-                    /* Are all args the same data ? */
-                    while (i) {
-                        i--;    /* do not move to while test, broken compilers */
-                        if (pargs[i].size != args[i].size ||
-                            XtMemcmp(pargs[i].addr, args[i].addr,
-                                     args[i].size)) {
-                            i++;
-                            break;
-                        }
-                    }
-                }
-                if (!i) {
-                    /* Perfect match */
-                    if (p->conversion_succeeded) {
-                        if (to->addr) { /* new-style call */
-                            if (to->size < p->to.size) {
-                                to->size = p->to.size;
-                                UNLOCK_PROCESS;
-                                return False;
-                            }
-                            to->size = p->to.size;
-                            if (p->to_is_value) {
-                                XtMemmove(to->addr, &p->to.addr, to->size);
-                            }
-                            else {
-                                (void) memmove((char *) to->addr,
-                                               (char *) p->to.addr, to->size);
-                            }
-                        }
-                        else {  /* old-style call */
-                            to->size = p->to.size;
-                            if (p->to_is_value)
-                                to->addr = (XPointer) &p->to.addr;
-                            else
-                                to->addr = p->to.addr;
-                        }
-                    }
-                    if (p->is_refcounted) {
-                        CEXT(p)->ref_count++;
-                        if (cache_ref_return)
-                            *cache_ref_return = (XtCacheRef) p;
-                        else
-                            p->is_refcounted = False;
-                    }
-                    else {
-                        if (cache_ref_return)
-                            *cache_ref_return = NULL;
-                    }
-                    retval = (p->conversion_succeeded);
+    hash = CacheHash((XtPointer) converter, args, num_args, from);
+
+    if (cP->cache_type != XtCacheNone &&
+        (p = CacheLookup(converter, args, num_args, from, hash))) {
+        if (p->conversion_succeeded) {
+            if (to->addr) {     /* new-style call */
+                if (to->size < p->to.size) {
+                    to->size = p->to.size;
                     UNLOCK_PROCESS;
-                    return retval;
+                    return False;
                 }
+                to->size = p->to.size;
+                if (p->to_is_value) {
+                    XtMemmove(to->addr, &p->to.addr, to->size);
+                }
+                else {
+                    (void) memmove((char *) to->addr,
+                                   (char *) p->to.addr, to->size);
+                }
+            }
+            else {              /* old-style call */
+                CachePin(p);
+                to->size = p->to.size;
+                if (p->to_is_value)
+                    to->addr = (XPointer) &p->to.addr;
+                else
+                    to->addr = p->to.addr;
             }
         }
+        if (p->is_refcounted) {
+            CEXT(p)->ref_count++;
+            if (cache_ref_return)
+                *cache_ref_return = (XtCacheRef) p;
+            else
+                p->is_refcounted = False;
+        }
+        else {
+            if (cache_ref_return)
+                *cache_ref_return = NULL;
+        }
+        retval = (p->conversion_succeeded);
+        UNLOCK_PROCESS;
+        return retval;
     }
 
     /* No cache entry, call converter procedure and enter result in cache */
@@ -859,7 +1075,8 @@ CallConverter(Display *dpy,
             heap = &XtDisplayToApplicationContext(dpy)->heap;
 
         p = CacheEnter(heap, converter, args, num_args, from, to, retval,
-                       hash, do_ref, do_free, cP->destructor, closure);
+                       hash, do_ref, do_free,
+                       cP->cache_type == XtCacheAll, cP->destructor, closure);
         if (do_ref)
             *cache_ref_return = (XtCacheRef) p;
         else if (cache_ref_return)
@@ -1096,13 +1313,36 @@ XtAppReleaseCacheRefs(XtAppContext app, XtCacheRef *refs)
     LOCK_PROCESS;
     for (r = (CachePtr *) refs; (p = *r); r++) {
         if (p->is_refcounted && --(CEXT(p)->ref_count) == 0) {
-            FreeCacheRec(app, p, NULL);
+            CacheRemove(p);
+            FreeCacheRec(app, p);
         }
     }
     UNLOCK_PROCESS;
     UNLOCK_APP(app);
 }
 
+/*
+ * Counts one more reference to each cache entry in refs, for a copy of
+ * the values they hold, and returns a new list for releasing it.
+ */
+XtCacheRef *
+_XtDuplicateCacheRefs(XtCacheRef *refs)
+{
+    register CachePtr *r;
+    XtCacheRef *copy;
+    Cardinal n;
+
+    LOCK_PROCESS;
+    for (r = (CachePtr *) refs; *r; r++)
+        if ((*r)->is_refcounted)
+            CEXT(*r)->ref_count++;
+    n = (Cardinal) (r - (CachePtr *) refs) + 1;
+    copy = (XtCacheRef *) __XtMalloc((Cardinal) (n * sizeof(XtCacheRef)));
+    (void) memmove(copy, refs, n * sizeof(XtCacheRef));
+    UNLOCK_PROCESS;
+    return copy;
+}
+
 void
 XtCallbackReleaseCacheRefList(Widget widget,
                               XtPointer closure,
@@ -90,6 +90,9 @@ in this Software without prior written authorization from The Open Group.
 externaldef(xtinherittranslations)
 int _XtInheritTranslations = 0;
 extern String XtCXtToolkitError;        /* from IntrinsicI.h */
+extern void _XtFlushEventIndex(Widget);  /* from Event.c */
+extern void _XtFlushSearchLists(Widget); /* from Resources.c */
+extern void _XtFlushGeometry(Widget);    /* from Geometry.c */
 static void
 XtCopyScreen(Widget, int, XrmValue *);
 
@@ -311,6 +314,9 @@ CoreRealize(Widget widget,
 static void
 CoreDestroy(Widget widget)
 {
+    _XtFlushEventIndex(widget);
+    _XtFlushSearchLists(widget);
+    _XtFlushGeometry(widget);
     _XtFreeEventTable(&widget->core.event_table);
     _XtDestroyTMData(widget);
     XtUnregisterDrawable(XtDisplay(widget), widget->core.window);
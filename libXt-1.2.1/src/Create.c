@@ -83,6 +83,27 @@ in this Software without prior written authorization from The Open Group.
 static _Xconst _XtString XtNxtCreateWidget = "xtCreateWidget";
 static _Xconst _XtString XtNxtCreatePopupShell = "xtCreatePopupShell";
 
+extern XtPointer _XtArenaAlloc(Widget, Cardinal);  /* from Alloc.c */
+extern void _XtIndexChildInserted(Widget);  /* from Intrinsic.c */
+extern void _XtCopyResources(Widget, Widget, ArgList, Cardinal);  /* from Resources.c */
+extern XtCacheRef *_XtDuplicateCacheRefs(XtCacheRef *);  /* from Convert.c */
+
+/*
+ * The resources shared by the children that XtCreateManagedWidgets makes:
+ * a record holding what _XtGetResources fetched for the shared args, the
+ * cache references taken by their conversions, and the args of the child
+ * being created.
+ */
+typedef struct _ResourceTemplateRec {
+    Widget widget;
+    XtCacheRef *cache_refs;
+    ArgList item_args;
+    Cardinal num_item_args;
+} ResourceTemplateRec, *ResourceTemplate;
+
+void XtCreateManagedWidgets(_Xconst char *, WidgetClass, Widget, Cardinal,
+                            ArgList, Cardinal, ArgList, Cardinal, WidgetList);
+
 static void
 CallClassPartInit(WidgetClass ancestor, WidgetClass wc)
 {
@@ -301,7 +322,9 @@ xtWidgetAlloc(WidgetClass widget_class,
                                         & ~(sizeof(double) - 1));
             }
         }
-        widget = (Widget) __XtCalloc(1, (unsigned) (wsize + csize));
+        widget = (Widget) _XtArenaAlloc(parent, wsize + csize);
+        if (!widget)
+            widget = (Widget) __XtCalloc(1, (unsigned) (wsize + csize));
         widget->core.constraints =
             (csize ? (XtPointer) ((char *) widget + wsize) : NULL);
     }
@@ -346,7 +369,8 @@ xtCreate(String name,
          Cardinal num_typed_args,
          ConstraintWidgetClass parent_constraint_class,
          /* NULL if not a subclass of Constraint or if child is popup shell */
-         XtWidgetProc post_proc)
+         XtWidgetProc post_proc,
+         ResourceTemplate template)     /* NULL to fetch the resources */
 {
     /* need to use strictest alignment rules possible in next two decls. */
     double widget_cache[100];
@@ -385,8 +409,15 @@ xtCreate(String name,
     UNLOCK_PROCESS;
 
     /* fetch resources */
-    cache_refs = _XtGetResources(widget, args, num_args,
-                                 typed_args, &num_typed_args);
+    if (template) {
+        _XtCopyResources(widget, template->widget,
+                         template->item_args, template->num_item_args);
+        cache_refs = template->cache_refs ?
+            _XtDuplicateCacheRefs(template->cache_refs) : NULL;
+    }
+    else
+        cache_refs = _XtGetResources(widget, args, num_args,
+                                     typed_args, &num_typed_args);
 
     /* Convert typed arg list to arg list */
     if (typed_args != NULL && num_typed_args > 0) {
@@ -496,17 +527,19 @@ widgetPostProc(Widget w)
     }
     else {
         (*insert_child) (w);
+        _XtIndexChildInserted(w);
     }
 }
 
-Widget
-_XtCreateWidget(String name,
-                WidgetClass widget_class,
-                Widget parent,
-                ArgList args,
-                Cardinal num_args,
-                XtTypedArgList typed_args,
-                Cardinal num_typed_args)
+static Widget
+CreateWidget(String name,
+             WidgetClass widget_class,
+             Widget parent,
+             ArgList args,
+             Cardinal num_args,
+             XtTypedArgList typed_args,
+             Cardinal num_typed_args,
+             ResourceTemplate template)
 {
     register Widget widget;
     ConstraintWidgetClass cwc;
@@ -580,10 +613,24 @@ _XtCreateWidget(String name,
     }
     widget = xtCreate(name, (char *) NULL, widget_class, parent,
                       default_screen, args, num_args,
-                      typed_args, num_typed_args, cwc, widgetPostProc);
+                      typed_args, num_typed_args, cwc, widgetPostProc,
+                      template);
     return (widget);
 }
 
+Widget
+_XtCreateWidget(String name,
+                WidgetClass widget_class,
+                Widget parent,
+                ArgList args,
+                Cardinal num_args,
+                XtTypedArgList typed_args,
+                Cardinal num_typed_args)
+{
+    return CreateWidget(name, widget_class, parent, args, num_args,
+                        typed_args, num_typed_args, (ResourceTemplate) NULL);
+}
+
 Widget
 XtCreateWidget(_Xconst char *name,
                WidgetClass widget_class,
@@ -623,6 +670,155 @@ XtCreateManagedWidget(_Xconst char *name,
     return widget;
 }
 
+/*
+ * Fetch the resources that args give a child of parent named name, once,
+ * into a private record that the children made by XtCreateManagedWidgets
+ * copy.
+ */
+static void
+InitResourceTemplate(ResourceTemplate template,
+                     String name,
+                     WidgetClass widget_class,
+                     Widget parent,
+                     ArgList args,
+                     Cardinal num_args)
+{
+    Cardinal wsize, csize = 0;
+    Cardinal num_typed_args = 0;
+    Widget widget;
+
+    LOCK_PROCESS;
+    wsize = widget_class->core_class.widget_size;
+    if (XtIsConstraint(parent))
+        csize = ((ConstraintWidgetClass) XtClass(parent))->
+            constraint_class.constraint_size;
+    UNLOCK_PROCESS;
+    wsize = (Cardinal) ((wsize + sizeof(double) - 1) & ~(sizeof(double) - 1));
+    widget = (Widget) __XtCalloc(1, wsize + csize);
+    widget->core.constraints =
+        (csize ? (XtPointer) ((char *) widget + wsize) : NULL);
+    widget->core.self = widget;
+    widget->core.parent = parent;
+    widget->core.widget_class = widget_class;
+    widget->core.xrm_name = StringToName((name != NULL) ? name : "");
+    widget->core.being_destroyed = parent->core.being_destroyed;
+    if (XtIsWidget(widget)) {
+        widget->core.name = XrmNameToString(widget->core.xrm_name);
+        widget->core.screen = parent->core.screen;
+        widget->core.visible = TRUE;
+    }
+    template->widget = widget;
+    template->cache_refs = _XtGetResources(widget, args, num_args,
+                                           (XtTypedArgList) NULL,
+                                           &num_typed_args);
+}
+
+static void
+FreeResourceTemplate(ResourceTemplate template)
+{
+    if (template->cache_refs) {
+        XtAppReleaseCacheRefs(XtWidgetToApplicationContext
+                              (template->widget->core.parent),
+                              template->cache_refs);
+        XtFree((char *) template->cache_refs);
+    }
+    XtFree((char *) template->widget);
+}
+
+/*
+ * Whether args name a resource that steers how the others are fetched,
+ * so that a child given them cannot copy the shared ones.
+ */
+static Boolean
+SteersResources(ArgList args, Cardinal num_args)
+{
+    static _Xconst char *names[] = {
+        XtNscreen, XtNcolormap, XtNdepth, XtNtranslations,
+        XtNinitialResourcesPersistent
+    };
+    Cardinal i, j;
+
+    for (i = 0; i < num_args; i++)
+        for (j = 0; j < XtNumber(names); j++)
+            if (strcmp(args[i].name, names[j]) == 0)
+                return True;
+    return False;
+}
+
+/*
+ * Create num_widgets managed children of parent with the same name and
+ * class.  Child i gets args followed by the num_item_args entries of
+ * item_args starting at i * num_item_args, so that its own args override
+ * the shared ones.  The resources for args are fetched from the database
+ * and converted once; each child copies them and sets its own args on
+ * top.  The children are managed together, so the change_managed
+ * procedure of the parent runs once, and their ids are returned in
+ * children_return if it is not NULL.
+ */
+void
+XtCreateManagedWidgets(_Xconst char *name,
+                       WidgetClass widget_class,
+                       Widget parent,
+                       Cardinal num_widgets,
+                       ArgList args,
+                       Cardinal num_args,
+                       ArgList item_args,
+                       Cardinal num_item_args,
+                       WidgetList children_return)
+{
+    Arg args_cache[32];
+    Widget children_cache[64];
+    ArgList merged_args;
+    WidgetList children;
+    ResourceTemplateRec template;
+    Boolean shared = False;
+    Cardinal i;
+
+    WIDGET_TO_APPCON(parent);
+
+    LOCK_APP(app);
+    XtCheckSubclass(parent, compositeWidgetClass, "in XtCreateManagedWidgets");
+    merged_args = (ArgList)
+        XtStackAlloc((num_args + num_item_args) * sizeof(Arg), args_cache);
+    children = children_return ? children_return : (WidgetList)
+        XtStackAlloc(num_widgets * sizeof(Widget), children_cache);
+    if (num_args)
+        (void) memcpy(merged_args, args, num_args * sizeof(Arg));
+    if (num_widgets > 1 && widget_class != NULL &&
+        !SteersResources(args, num_args)) {
+        LOCK_PROCESS;
+        if (!widget_class->core_class.class_inited)
+            XtInitializeWidgetClass(widget_class);
+        shared = !(widget_class->core_class.class_inited & ShellClassFlag);
+        UNLOCK_PROCESS;
+        if (shared)
+            InitResourceTemplate(&template, (String) name, widget_class,
+                                 parent, args, num_args);
+    }
+    for (i = 0; i < num_widgets; i++) {
+        ArgList own_args = item_args + i * num_item_args;
+
+        if (num_item_args)
+            (void) memcpy(merged_args + num_args, own_args,
+                          num_item_args * sizeof(Arg));
+        template.item_args = own_args;
+        template.num_item_args = num_item_args;
+        children[i] =
+            CreateWidget((String) name, widget_class, parent, merged_args,
+                         num_args + num_item_args, (XtTypedArgList) NULL,
+                         (Cardinal) 0,
+                         shared && !SteersResources(own_args, num_item_args)
+                         ? &template : (ResourceTemplate) NULL);
+    }
+    XtManageChildren(children, num_widgets);
+    if (shared)
+        FreeResourceTemplate(&template);
+    if (!children_return)
+        XtStackFree((XtPointer) children, children_cache);
+    XtStackFree((XtPointer) merged_args, args_cache);
+    UNLOCK_APP(app);
+}
+
 static void
 popupPostProc(Widget w)
 {
@@ -634,6 +830,7 @@ popupPostProc(Widget w)
                                            (parent->core.num_popups +
                                             1) * sizeof(Widget)));
     parent->core.popup_list[parent->core.num_popups++] = w;
+    _XtIndexChildInserted(w);
 }
 
 Widget
@@ -663,7 +860,7 @@ _XtCreatePopupShell(String name,
     widget = xtCreate(name, (char *) NULL, widget_class, parent,
                       default_screen, args, num_args, typed_args,
                       num_typed_args, (ConstraintWidgetClass) NULL,
-                      popupPostProc);
+                      popupPostProc, (ResourceTemplate) NULL);
 
 #ifndef X_NO_RESOURCE_CONFIGURATION_MANAGEMENT
     XtAddEventHandler(widget, (EventMask) PropertyChangeMask, FALSE,
@@ -713,7 +910,8 @@ _XtAppCreateShell(String name,
     shell = xtCreate(name, class, widget_class, (Widget) NULL,
                      (Screen *) DefaultScreenOfDisplay(display),
                      args, num_args, typed_args, num_typed_args,
-                     (ConstraintWidgetClass) NULL, _XtAddShellToHookObj);
+                     (ConstraintWidgetClass) NULL, _XtAddShellToHookObj,
+                     (ResourceTemplate) NULL);
 
 #ifndef X_NO_RESOURCE_CONFIGURATION_MANAGEMENT
     XtAddEventHandler(shell, (EventMask) PropertyChangeMask, FALSE,
@@ -73,6 +73,11 @@ in this Software without prior written authorization from The Open Group.
 #endif
 #include "IntrinsicI.h"
 
+extern Boolean _XtArenaRelease(Widget);   /* from Alloc.c */
+extern void _XtDeleteChildren(Widget, WidgetList, Cardinal);  /* from Composite.c */
+extern void _XtIndexChildDeleted(Widget);  /* from Intrinsic.c */
+extern void _XtInvalidateNameCache(void);  /* from Intrinsic.c */
+
 struct _DestroyRec {
     int dispatch_level;
     Widget widget;
@@ -135,6 +140,7 @@ Phase2Destroy(register Widget widget)
     register WidgetClass class;
     register ConstraintWidgetClass cwClass;
     ObjectClassExtension ext;
+    Boolean in_arena;
 
     /* Call constraint destroy procedures */
     if (XtParent(widget) != NULL && !XtIsShell(widget) &&
@@ -172,6 +178,7 @@ Phase2Destroy(register Widget widget)
     }
 
     /* Call widget deallocate procedure */
+    in_arena = _XtArenaRelease(widget);
     ext = (ObjectClassExtension) XtGetClassExtension(widget->core.widget_class,
                                                      XtOffsetOf(CoreClassPart,
                                                                 extension),
@@ -188,7 +195,8 @@ Phase2Destroy(register Widget widget)
     }
     else {
         UNLOCK_PROCESS;
-        XtFree((char *) widget);
+        if (!in_arena)
+            XtFree((char *) widget);
     }
 }                               /* Phase2Destroy */
 
@@ -202,8 +210,26 @@ IsDescendant(Widget widget, Widget root)
     return True;
 }
 
+static Boolean
+IsPopup(Widget widget, Widget parent)
+{
+    Cardinal i;
+
+    if (parent && XtIsWidget(parent)) {
+        for (i = 0; i < parent->core.num_popups; i++) {
+            if (parent->core.popup_list[i] == widget)
+                return True;
+        }
+    }
+    return False;
+}
+
+/*
+ * The widget has already been unmanaged and removed from its parent
+ * when detached is True; see _XtDoPhase2Destroy.
+ */
 static void
-XtPhase2Destroy(Widget widget)
+XtPhase2Destroy(Widget widget, Boolean detached)
 {
     Display *display = NULL;
     Window window;
@@ -217,19 +243,13 @@ XtPhase2Destroy(Widget widget)
     _XtGetPerDisplay(XtDisplayOfObject(widget))->pdi.traceDepth = 0;
 
     parent = widget->core.parent;
+    if (!detached)
+        _XtIndexChildDeleted(widget);
 
-    if (parent && XtIsWidget(parent) && parent->core.num_popups) {
-        Cardinal i;
+    if (parent && parent->core.num_popups)
+        isPopup = IsPopup(widget, parent);
 
-        for (i = 0; i < parent->core.num_popups; i++) {
-            if (parent->core.popup_list[i] == widget) {
-                isPopup = True;
-                break;
-            }
-        }
-    }
-
-    if (!isPopup && parent && XtIsComposite(parent)) {
+    if (!detached && !isPopup && parent && XtIsComposite(parent)) {
         XtWidgetProc delete_child;
 
         LOCK_PROCESS;
@@ -279,23 +299,20 @@ XtPhase2Destroy(Widget widget)
 
             DestroyRec *dr = app->destroy_list + i;
 
-            if (IsDescendant(dr->widget, widget)) {
+            if (dr->widget && IsDescendant(dr->widget, widget)) {
                 Widget descendant = dr->widget;
-                register int j;
 
-                app->destroy_count--;
-                for (j = app->destroy_count - i; --j >= 0; dr++)
-                    *dr = *(dr + 1);
-                XtPhase2Destroy(descendant);
+                dr->widget = NULL;
+                XtPhase2Destroy(descendant, False);
             }
-            else
-                i++;
+            i++;
         }
     }
 
     app->in_phase2_destroy = widget;
     Recursive(widget, Phase2Destroy);
     app->in_phase2_destroy = outerInPhase2Destroy;
+    _XtInvalidateNameCache();
 
     if (isPopup) {
         Cardinal i;
@@ -319,6 +336,94 @@ XtPhase2Destroy(Widget widget)
         XDestroyWindow(display, window);
 }                               /* XtPhase2Destroy */
 
+/*
+ * Entries taken off the destroy list are cleared instead of shifted out,
+ * which made a burst of n destroys cost O(n^2).  The list is compacted
+ * once the outermost pass over it has finished, so that the indices held
+ * by the passes further up the stack stay valid until then.  The nesting
+ * count belongs to the application context, so each context being walked
+ * has an entry here for as long as a pass over its list is active.
+ */
+typedef struct _DestroyListUsersRec {
+    struct _DestroyListUsersRec *next;
+    XtAppContext app;
+    int users;
+} DestroyListUsersRec, *DestroyListUsers;
+
+static DestroyListUsers destroyListUsers = NULL;
+
+void
+_XtEnterDestroyList(XtAppContext app)
+{
+    DestroyListUsers du;
+
+    LOCK_PROCESS;
+    for (du = destroyListUsers; du; du = du->next)
+        if (du->app == app)
+            break;
+    if (du == NULL) {
+        du = XtNew(DestroyListUsersRec);
+        du->app = app;
+        du->users = 0;
+        du->next = destroyListUsers;
+        destroyListUsers = du;
+    }
+    du->users++;
+    UNLOCK_PROCESS;
+}
+
+void
+_XtLeaveDestroyList(XtAppContext app)
+{
+    DestroyListUsers du, *prev;
+    int i, j;
+
+    LOCK_PROCESS;
+    for (prev = &destroyListUsers; (du = *prev); prev = &du->next)
+        if (du->app == app)
+            break;
+    if (du && --du->users == 0) {
+        *prev = du->next;
+        XtFree((char *) du);
+        for (i = j = 0; i < app->destroy_count; i++)
+            if (app->destroy_list[i].widget)
+                app->destroy_list[j++] = app->destroy_list[i];
+        app->destroy_count = j;
+    }
+    UNLOCK_PROCESS;
+}
+
+/*
+ * Siblings destroyed one after the other, as when a container is
+ * emptied child by child, are taken off the list together: the run
+ * starts at entry i and ends at the first due entry with another
+ * parent.  Returns the length of the run, storing it in list if given.
+ */
+static Cardinal
+CollectSiblings(XtAppContext app, int i, int dispatch_level, WidgetList list)
+{
+    Widget parent = app->destroy_list[i].widget->core.parent;
+    Cardinal n = 0;
+
+    if (parent == NULL || !XtIsComposite(parent))
+        return 0;
+    for (; i < app->destroy_count; i++) {
+        DestroyRec *dr = app->destroy_list + i;
+
+        if (dr->widget == NULL || dr->dispatch_level < dispatch_level)
+            continue;
+        if (dr->widget->core.parent != parent ||
+            (parent->core.num_popups && IsPopup(dr->widget, parent)))
+            break;
+        if (list) {
+            list[n] = dr->widget;
+            dr->widget = NULL;
+        }
+        n++;
+    }
+    return n;
+}
+
 void
 _XtDoPhase2Destroy(XtAppContext app, int dispatch_level)
 {
@@ -328,6 +433,7 @@ _XtDoPhase2Destroy(XtAppContext app, int dispatch_level)
 
     int i = 0;
 
+    _XtEnterDestroyList(app);
     while (i < app->destroy_count) {
 
         /* XtPhase2Destroy can result in calls to XtDestroyWidget,
@@ -336,18 +442,30 @@ _XtDoPhase2Destroy(XtAppContext app, int dispatch_level)
 
         DestroyRec *dr = app->destroy_list + i;
 
-        if (dr->dispatch_level >= dispatch_level) {
+        if (dr->widget && dr->dispatch_level >= dispatch_level) {
             Widget w = dr->widget;
-            register int j;
-
-            app->destroy_count--;
-            for (j = app->destroy_count - i; --j >= 0; dr++)
-                *dr = *(dr + 1);
-            XtPhase2Destroy(w);
+            Cardinal n = CollectSiblings(app, i, dispatch_level, NULL);
+
+            if (n > 1) {
+                Widget cache[64];
+                WidgetList siblings = (WidgetList)
+                    XtStackAlloc(n * sizeof(Widget), cache);
+                Cardinal k;
+
+                CollectSiblings(app, i, dispatch_level, siblings);
+                _XtDeleteChildren(w->core.parent, siblings, n);
+                for (k = 0; k < n; k++)
+                    XtPhase2Destroy(siblings[k], True);
+                XtStackFree((XtPointer) siblings, cache);
+            }
+            else {
+                dr->widget = NULL;
+                XtPhase2Destroy(w, False);
+            }
         }
-        else
-            i++;
+        i++;
     }
+    _XtLeaveDestroyList(app);
 }
 
 void
@@ -365,7 +483,7 @@ XtDestroyWidget(Widget widget)
     Recursive(widget, Phase1Destroy);
 
     if (app->in_phase2_destroy && IsDescendant(widget, app->in_phase2_destroy)) {
-        XtPhase2Destroy(widget);
+        XtPhase2Destroy(widget, False);
         UNLOCK_APP(app);
         return;
     }
@@ -388,7 +506,7 @@ XtDestroyWidget(Widget widget)
         for (i = app->destroy_count - 1; i;) {
             /* this handles only one case of nesting difficulties */
             dr = app->destroy_list + (--i);
-            if (dr->dispatch_level < app->dispatch_level &&
+            if (dr->widget && dr->dispatch_level < app->dispatch_level &&
                 IsDescendant(dr->widget, widget)) {
                 DestroyRec *dr2 = app->destroy_list + (app->destroy_count - 1);
 
@@ -86,6 +86,9 @@ void (*_XtInitAppLock) (XtAppContext) = NULL;
 
 static _Xconst _XtString XtNnoPerDisplay = "noPerDisplay";
 
+extern void _XtFreeKeycodeTable(XtPerDisplay);  /* from TMkey.c */
+extern void _XtFlushSearchLists(Widget);        /* from Resources.c */
+
 ProcessContext
 _XtGetProcessContext(void)
 {
@@ -685,6 +688,7 @@ CloseDisplay(Display *dpy)
             XFree((char *) xtpd->keysyms);
         XtFree((char *) xtpd->modKeysyms);
         XtFree((char *) xtpd->modsToKeysyms);
+        _XtFreeKeycodeTable(xtpd);
         xtpd->keysyms_per_keycode = 0;
         xtpd->being_destroyed = FALSE;
         xtpd->keysyms = NULL;
@@ -696,6 +700,7 @@ CloseDisplay(Display *dpy)
         XtFree((char *) xtpd->pdi.trace);
         _XtHeapFree(&xtpd->heap);
         _XtFreeWWTable(xtpd);
+        _XtFlushSearchLists(NULL);
         xtpd->per_screen_db[DefaultScreen(dpy)] = (XrmDatabase) NULL;
         for (i = ScreenCount(dpy); --i >= 0;) {
             db = xtpd->per_screen_db[i];
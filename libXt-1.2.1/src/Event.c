@@ -85,6 +85,9 @@ typedef struct _XtEventRecExt {
 
 #define NonMaskableMask ((EventMask)0x80000000L)
 
+void _XtFlushEventIndex(Widget);
+Boolean _XtCallEventHandlers(Widget, XEvent *, EventMask, Boolean *);
+
 /*
  * These are definitions to make the code that handles exposure compresssion
  * easier to read.
@@ -233,6 +236,7 @@ RemoveEventHandler(Widget widget,
         *pp = p->next;
         XtFree((char *) p);
     }
+    _XtFlushEventIndex(widget);
 
     /* Reset select mask if realized and not raw. */
     if (!raw && XtIsRealized(widget) && !widget->core.being_destroyed) {
@@ -379,6 +383,7 @@ AddEventHandler(Widget widget,
             }
         }
     }
+    _XtFlushEventIndex(widget);
 
     if (XtIsRealized(widget) && !raw) {
         EventMask mask = XtBuildEventMask(widget);
@@ -745,73 +750,247 @@ _XtFreeWWTable(register XtPerDisplay pd)
     XtFree((char *) pd->WWtable);
 }
 
-#define EHMAXSIZE 25            /* do not make whopping big */
+/*
+ * Handler index.  Rather than walking a widget's whole event table and
+ * testing every mask for every event, the dispatcher keeps per widget a
+ * copy of its handlers grouped by the event type they can match, so that
+ * it only looks at handlers that are interested in the event.  The index
+ * is built on the first dispatch to the widget and discarded whenever
+ * its event table changes.  A dispatch in progress holds a reference to
+ * its index, so handlers may freely add or remove handlers while it is
+ * in use; this keeps the "copy" semantics of the event table.
+ */
+
+#define KnownButtons (Button1MotionMask|Button2MotionMask|Button3MotionMask|\
+                      Button4MotionMask|Button5MotionMask)
+
+typedef struct _XtHandlerRec {
+    XtEventHandler proc;
+    XtPointer closure;
+    EventMask mask;             /* if !has_type_specifier */
+    int type;                   /* if has_type_specifier */
+    Boolean has_type_specifier;
+} XtHandlerRec;
+
+typedef struct _XtEventIndexRec {
+    Widget widget;
+    struct _XtEventIndexRec *next;      /* hash chain */
+    int refcount;                       /* dispatches using this index */
+    Boolean stale;                      /* removed from the hash table */
+    Cardinal first[LASTEvent + 1];      /* handlers for type t are
+                                           handlers[first[t]..first[t+1]-1];
+                                           those from first[LASTEvent]
+                                           on are for extension events */
+    Cardinal count;
+    XtHandlerRec *handlers;
+} XtEventIndexRec, *XtEventIndex;
+
+static struct {
+    XtEventIndex *buckets;
+    Cardinal size;              /* a power of two */
+    Cardinal count;
+} eventIndexes;
+
+#define EVENT_INDEX_HASH(widget, size) \
+    ((Cardinal) (((unsigned long) (widget) >> 4) & ((size) - 1)))
 
 static Boolean
-CallEventHandlers(Widget widget, XEvent *event, EventMask mask)
+HandlerMatchesType(XtEventRec *p, int type)
 {
-    register XtEventRec *p;
-    XtEventHandler *proc;
-    XtPointer *closure;
-    Boolean cont_to_disp = True;
-    int i, numprocs;
-
-    /* Have to copy the procs into an array, because one of them might
-     * call XtRemoveEventHandler, which would break our linked list. */
-
-    numprocs = 0;
-    for (p = widget->core.event_table; p; p = p->next) {
-        if ((!p->has_type_specifier && (mask & p->mask)) ||
-            (p->has_type_specifier && event->type == EXT_TYPE(p)))
-            numprocs++;
+    EventMask mask;
+
+    if (p->has_type_specifier)
+        return EXT_TYPE(p) == type;
+    mask = _XtConvertTypeToMask(type);
+    if (type == MotionNotify)
+        mask |= KnownButtons;
+    return (p->mask & mask) != 0;
+}
+
+static void
+CopyHandler(XtHandlerRec *handler, XtEventRec *p)
+{
+    handler->proc = p->proc;
+    handler->closure = p->closure;
+    handler->mask = p->mask;
+    handler->type = p->has_type_specifier ? EXT_TYPE(p) : 0;
+    handler->has_type_specifier = p->has_type_specifier;
+}
+
+static XtEventIndex
+BuildEventIndex(Widget widget)
+{
+    XtEventIndex index;
+    XtEventRec *p;
+    Cardinal count = 0;
+    int type;
+
+    for (type = 0; type < LASTEvent; type++)
+        for (p = widget->core.event_table; p; p = p->next)
+            if (HandlerMatchesType(p, type))
+                count++;
+    for (p = widget->core.event_table; p; p = p->next)
+        if (p->has_type_specifier && EXT_TYPE(p) >= LASTEvent)
+            count++;
+
+    index = (XtEventIndex) __XtMalloc((Cardinal) (sizeof(XtEventIndexRec) +
+                                                  count *
+                                                  sizeof(XtHandlerRec)));
+    index->widget = widget;
+    index->refcount = 0;
+    index->stale = False;
+    index->handlers = (XtHandlerRec *) (index + 1);
+
+    count = 0;
+    for (type = 0; type < LASTEvent; type++) {
+        index->first[type] = count;
+        for (p = widget->core.event_table; p; p = p->next)
+            if (HandlerMatchesType(p, type))
+                CopyHandler(&index->handlers[count++], p);
     }
-    proc = (XtEventHandler *)
-        __XtMalloc((Cardinal)
-                   ((size_t) numprocs *
-                    (sizeof(XtEventHandler) + sizeof(XtPointer))));
-    closure = (XtPointer *) (proc + numprocs);
-
-    numprocs = 0;
-    for (p = widget->core.event_table; p; p = p->next) {
-        if ((!p->has_type_specifier && (mask & p->mask)) ||
-            (p->has_type_specifier && event->type == EXT_TYPE(p))) {
-            proc[numprocs] = p->proc;
-            closure[numprocs] = p->closure;
-            numprocs++;
+    index->first[LASTEvent] = count;
+    for (p = widget->core.event_table; p; p = p->next)
+        if (p->has_type_specifier && EXT_TYPE(p) >= LASTEvent)
+            CopyHandler(&index->handlers[count++], p);
+    index->count = count;
+    return index;
+}
+
+static void
+ExpandEventIndexes(void)
+{
+    XtEventIndex *buckets, index, next;
+    Cardinal size, i, j;
+
+    size = eventIndexes.size ? eventIndexes.size << 1 : 64;
+    buckets = (XtEventIndex *)
+        __XtCalloc(size, (Cardinal) sizeof(XtEventIndex));
+    for (i = 0; i < eventIndexes.size; i++) {
+        for (index = eventIndexes.buckets[i]; index; index = next) {
+            next = index->next;
+            j = EVENT_INDEX_HASH(index->widget, size);
+            index->next = buckets[j];
+            buckets[j] = index;
         }
     }
-    /* FUNCTIONS CALLED THROUGH POINTER proc:
-       Selection.c:ReqCleanup,
-       "Shell.c":EventHandler,
-       PassivGrab.c:ActiveHandler,
-       PassivGrab.c:RealizeHandler,
-       Keyboard.c:QueryEventMask,
-       _XtHandleFocus,
-       Selection.c:HandleSelectionReplies,
-       Selection.c:HandleGetIncrement,
-       Selection.c:HandleIncremental,
-       Selection.c:HandlePropertyGone,
-       Selection.c:HandleSelectionEvents
-     */
-    for (i = 0; i < numprocs && cont_to_disp; i++)
-        (*(proc[i])) (widget, closure[i], event, &cont_to_disp);
-    XtFree((char *) proc);
-    return cont_to_disp;
+    XtFree((char *) eventIndexes.buckets);
+    eventIndexes.buckets = buckets;
+    eventIndexes.size = size;
 }
 
-static void CompressExposures(XEvent *, Widget);
+static XtEventIndex
+GetEventIndex(Widget widget)
+{
+    XtEventIndex index;
+    Cardinal i;
+
+    if (eventIndexes.size) {
+        i = EVENT_INDEX_HASH(widget, eventIndexes.size);
+        for (index = eventIndexes.buckets[i]; index; index = index->next)
+            if (index->widget == widget)
+                return index;
+    }
+    if (eventIndexes.count >= eventIndexes.size)
+        ExpandEventIndexes();
+    index = BuildEventIndex(widget);
+    i = EVENT_INDEX_HASH(widget, eventIndexes.size);
+    index->next = eventIndexes.buckets[i];
+    eventIndexes.buckets[i] = index;
+    eventIndexes.count++;
+    return index;
+}
 
-#define KnownButtons (Button1MotionMask|Button2MotionMask|Button3MotionMask|\
-                      Button4MotionMask|Button5MotionMask)
+/*
+ * Discards the handler index of widget, if any; called whenever the
+ * widget's event table changes or the widget is destroyed.
+ */
+void
+_XtFlushEventIndex(Widget widget)
+{
+    XtEventIndex index, *prev;
 
-/* keep this SMALL to avoid blowing stack cache! */
-/* because some compilers allocate all local locals on procedure entry */
-#define EHSIZE 4
+    LOCK_PROCESS;
+    if (eventIndexes.size) {
+        prev = &eventIndexes.buckets[EVENT_INDEX_HASH(widget,
+                                                      eventIndexes.size)];
+        for (index = *prev; index; prev = &index->next, index = *prev) {
+            if (index->widget == widget) {
+                *prev = index->next;
+                eventIndexes.count--;
+                if (index->refcount)
+                    index->stale = True;
+                else
+                    XtFree((char *) index);
+                break;
+            }
+        }
+    }
+    UNLOCK_PROCESS;
+}
+
+/*
+ * Calls the event handlers of widget that select event, until one of
+ * them clears *cont_to_disp.  Returns True if any handler matched.
+ */
+Boolean
+_XtCallEventHandlers(Widget widget,
+                     XEvent *event,
+                     EventMask mask,
+                     Boolean *cont_to_disp)
+{
+    XtEventIndex index;
+    XtHandlerRec *handler, *last;
+    Boolean was_dispatched = False;
+
+    if (!widget->core.event_table)
+        return False;
+
+    LOCK_PROCESS;
+    index = GetEventIndex(widget);
+    index->refcount++;
+    UNLOCK_PROCESS;
+
+    if ((unsigned) event->type < LASTEvent) {
+        handler = index->handlers + index->first[event->type];
+        last = index->handlers + index->first[event->type + 1];
+    }
+    else {
+        handler = index->handlers + index->first[LASTEvent];
+        last = index->handlers + index->count;
+    }
+    for (; handler < last && *cont_to_disp; handler++) {
+        if (handler->has_type_specifier ? event->type == handler->type
+                                        : (mask & handler->mask) != 0) {
+            (*handler->proc) (widget, handler->closure, event, cont_to_disp);
+            /* FUNCTIONS CALLED THROUGH POINTER handler->proc:
+               Selection.c:ReqCleanup,
+               "Shell.c":EventHandler,
+               PassivGrab.c:ActiveHandler,
+               PassivGrab.c:RealizeHandler,
+               Keyboard.c:QueryEventMask,
+               _XtHandleFocus,
+               Selection.c:HandleSelectionReplies,
+               Selection.c:HandleGetIncrement,
+               Selection.c:HandleIncremental,
+               Selection.c:HandlePropertyGone,
+               Selection.c:HandleSelectionEvents
+             */
+            was_dispatched = True;
+        }
+    }
+
+    LOCK_PROCESS;
+    if (--index->refcount == 0 && index->stale)
+        XtFree((char *) index);
+    UNLOCK_PROCESS;
+    return was_dispatched;
+}
+
+static void CompressExposures(XEvent *, Widget);
 
 Boolean
 XtDispatchEventToWidget(Widget widget, XEvent *event)
 {
-    register XtEventRec *p;
     Boolean was_dispatched = False;
     Boolean call_tm = False;
     Boolean cont_to_disp;
@@ -876,58 +1055,8 @@ XtDispatchEventToWidget(Widget widget, XEvent *event)
         call_tm = True;
 
     cont_to_disp = True;
-    p = widget->core.event_table;
-    if (p) {
-        if (p->next) {
-            XtEventHandler proc[EHSIZE];
-            XtPointer closure[EHSIZE];
-            int numprocs = 0;
-
-            /* Have to copy the procs into an array, because one of them might
-             * call XtRemoveEventHandler, which would break our linked list. */
-
-            for (; p; p = p->next) {
-                if ((!p->has_type_specifier && (mask & p->mask)) ||
-                    (p->has_type_specifier && event->type == EXT_TYPE(p))) {
-                    if (numprocs >= EHSIZE)
-                        break;
-                    proc[numprocs] = p->proc;
-                    closure[numprocs] = p->closure;
-                    numprocs++;
-                }
-            }
-            if (numprocs) {
-                if (p) {
-                    cont_to_disp = CallEventHandlers(widget, event, mask);
-                }
-                else {
-                    int i;
-
-                    for (i = 0; i < numprocs && cont_to_disp; i++)
-                        (*(proc[i])) (widget, closure[i], event, &cont_to_disp);
-                    /* FUNCTIONS CALLED THROUGH POINTER proc:
-                       Selection.c:ReqCleanup,
-                       "Shell.c":EventHandler,
-                       PassivGrab.c:ActiveHandler,
-                       PassivGrab.c:RealizeHandler,
-                       Keyboard.c:QueryEventMask,
-                       _XtHandleFocus,
-                       Selection.c:HandleSelectionReplies,
-                       Selection.c:HandleGetIncrement,
-                       Selection.c:HandleIncremental,
-                       Selection.c:HandlePropertyGone,
-                       Selection.c:HandleSelectionEvents
-                     */
-                }
-                was_dispatched = True;
-            }
-        }
-        else if ((!p->has_type_specifier && (mask & p->mask)) ||
-                 (p->has_type_specifier && event->type == EXT_TYPE(p))) {
-            (*p->proc) (widget, p->closure, event, &cont_to_disp);
-            was_dispatched = True;
-        }
-    }
+    if (_XtCallEventHandlers(widget, event, mask, &cont_to_disp))
+        was_dispatched = True;
     if (call_tm && cont_to_disp)
         _XtTranslateEvent(widget, event);
     UNLOCK_APP(app);
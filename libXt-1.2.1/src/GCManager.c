@@ -82,15 +82,54 @@ typedef struct _GCrec {
     GC gc;                      /* The GC itself. */
     XtGCMask dynamic_mask;      /* Writable values */
     XtGCMask unused_mask;       /* Unused values */
-    struct _GCrec *next;        /* Next GC for this widgetkind. */
+    unsigned long hash;         /* Hash of the request that created it */
+    struct _GCrec *next;        /* Next GC in this request bucket */
+    struct _GCrec *gc_next;     /* Next GC in this GContext bucket */
 } GCrec, *GCptr;
 
+/*
+ * The shared GCs of a display are kept in a hash table keyed by the
+ * request that created them: the screen, the depth, the dynamic and
+ * unused masks, and the read-only values with their defaults filled in.
+ * A request is only matched against the GCs in its own bucket, so a
+ * compatible GC that was created by a different request is not shared.
+ * A second table, keyed by the GC itself, serves XtReleaseGC.
+ */
+typedef struct _GCTableRec {
+    struct _GCTableRec *next;
+    XtPerDisplay pd;
+    Cardinal size;              /* a power of two */
+    Cardinal count;
+    GCptr *buckets;             /* chained through next */
+    GCptr *gcBuckets;           /* chained through gc_next */
+} GCTableRec, *GCTable;
+
+static GCTable gcTables;
+
+static struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long entries;
+} gcStatistics;
+
+#define GC_HASH(hash, size) ((Cardinal) ((hash) & ((size) - 1)))
+
+#define GC_ID_HASH(gc, size) \
+    ((Cardinal) (((unsigned long) (gc) >> 4) & ((size) - 1)))
+
+void _XtGetGCStatistics(unsigned long *, unsigned long *, unsigned long *);
+
 #define GCVAL(bit,mask,val,default) ((bit&mask) ? val : default)
 
 #define CHECK(bit,comp,default) \
     if ((checkMask & bit) && \
         (GCVAL(bit,valueMask,v->comp,default) != gcv.comp)) return False
 
+#define HASH(bit,comp,default) \
+    if (readOnlyMask & bit) \
+        hash = hash * 1000003UL ^ \
+               (unsigned long) GCVAL(bit,valueMask,v->comp,default)
+
 #define ALLGCVALS (GCFunction | GCPlaneMask | GCForeground | \
                    GCBackground | GCLineWidth | GCLineStyle | \
                    GCCapStyle | GCJoinStyle | GCFillStyle | \
@@ -100,6 +139,44 @@ typedef struct _GCrec {
                    GCClipXOrigin | GCClipYOrigin | GCDashOffset | \
                    GCArcMode)
 
+static unsigned long
+HashRequest(int screen,
+            Cardinal depth,
+            XtGCMask valueMask,
+            XGCValues *v,
+            XtGCMask readOnlyMask,
+            XtGCMask dynamicMask)
+{
+    unsigned long hash;
+
+    hash = ((unsigned long) screen << 8 | depth) * 1000003UL ^ dynamicMask;
+    hash = hash * 1000003UL ^ readOnlyMask;
+    HASH(GCForeground, foreground, 0);
+    HASH(GCBackground, background, 1);
+    HASH(GCFont, font, ~0UL);
+    HASH(GCFillStyle, fill_style, FillSolid);
+    HASH(GCLineWidth, line_width, 0);
+    HASH(GCFunction, function, GXcopy);
+    HASH(GCGraphicsExposures, graphics_exposures, True);
+    HASH(GCTile, tile, ~0UL);
+    HASH(GCSubwindowMode, subwindow_mode, ClipByChildren);
+    HASH(GCPlaneMask, plane_mask, AllPlanes);
+    HASH(GCLineStyle, line_style, LineSolid);
+    HASH(GCCapStyle, cap_style, CapButt);
+    HASH(GCJoinStyle, join_style, JoinMiter);
+    HASH(GCFillRule, fill_rule, EvenOddRule);
+    HASH(GCArcMode, arc_mode, ArcPieSlice);
+    HASH(GCStipple, stipple, ~0UL);
+    HASH(GCTileStipXOrigin, ts_x_origin, 0);
+    HASH(GCTileStipYOrigin, ts_y_origin, 0);
+    HASH(GCClipXOrigin, clip_x_origin, 0);
+    HASH(GCClipYOrigin, clip_y_origin, 0);
+    HASH(GCDashOffset, dash_offset, 0);
+    HASH(GCClipMask, clip_mask, None);
+    HASH(GCDashList, dashes, 4);
+    return hash ^ (hash >> 17);
+}                               /* HashRequest */
+
 static Bool
 Matches(Display *dpy,
         GCptr ptr,
@@ -156,17 +233,99 @@ Matches(Display *dpy,
     return True;
 }                               /* Matches */
 
+static GCTable
+FindGCTable(XtPerDisplay pd)
+{
+    GCTable table;
+
+    for (table = gcTables; table; table = table->next)
+        if (table->pd == pd)
+            break;
+    return table;
+}
+
+static void
+ExpandGCTable(GCTable table)
+{
+    GCptr *buckets, *gcBuckets, cur, next;
+    Cardinal size, i, j;
+
+    size = table->size ? table->size << 1 : 64;
+    buckets = (GCptr *) __XtCalloc(size, (Cardinal) sizeof(GCptr));
+    gcBuckets = (GCptr *) __XtCalloc(size, (Cardinal) sizeof(GCptr));
+    for (i = 0; i < table->size; i++) {
+        for (cur = table->buckets[i]; cur; cur = next) {
+            next = cur->next;
+            j = GC_HASH(cur->hash, size);
+            cur->next = buckets[j];
+            buckets[j] = cur;
+        }
+        for (cur = table->gcBuckets[i]; cur; cur = next) {
+            next = cur->gc_next;
+            j = GC_ID_HASH(cur->gc, size);
+            cur->gc_next = gcBuckets[j];
+            gcBuckets[j] = cur;
+        }
+    }
+    XtFree((char *) table->buckets);
+    XtFree((char *) table->gcBuckets);
+    table->buckets = buckets;
+    table->gcBuckets = gcBuckets;
+    table->size = size;
+}
+
+/*
+ * Drop one reference to gc if it is in table; the GC is freed when the
+ * last reference goes.  Returns False if the GC is not in the table.
+ */
+static Boolean
+ReleaseGC(Display *dpy, GCTable table, GC gc)
+{
+    GCptr cur, *prev;
+
+    for (prev = &table->gcBuckets[GC_ID_HASH(gc, table->size)];
+         (cur = *prev); prev = &cur->gc_next) {
+        if (cur->gc == gc)
+            break;
+    }
+    if (!cur)
+        return False;
+    if (--(cur->ref_count) == 0) {
+        *prev = cur->gc_next;
+        for (prev = &table->buckets[GC_HASH(cur->hash, table->size)];
+             *prev != cur; prev = &(*prev)->next);
+        *prev = cur->next;
+        table->count--;
+        gcStatistics.entries--;
+        XFreeGC(dpy, gc);
+        XtFree((char *) cur);
+    }
+    return True;
+}
+
 /* Called by CloseDisplay to free the per-display GC list */
 void
 _XtGClistFree(Display *dpy, register XtPerDisplay pd)
 {
-    GCptr GClist, next;
-
-    GClist = pd->GClist;
-    while (GClist) {
-        next = GClist->next;
-        XtFree((char *) GClist);
-        GClist = next;
+    GCTable table, *tablePtr;
+    GCptr cur, next;
+    Cardinal i;
+
+    for (tablePtr = &gcTables; (table = *tablePtr); tablePtr = &table->next) {
+        if (table->pd == pd) {
+            *tablePtr = table->next;
+            for (i = 0; i < table->size; i++) {
+                for (cur = table->buckets[i]; cur; cur = next) {
+                    next = cur->next;
+                    XtFree((char *) cur);
+                }
+            }
+            gcStatistics.entries -= table->count;
+            XtFree((char *) table->buckets);
+            XtFree((char *) table->gcBuckets);
+            XtFree((char *) table);
+            break;
+        }
     }
     if (pd->pixmap_tab) {
         int i;
@@ -179,6 +338,22 @@ _XtGClistFree(Display *dpy, register XtPerDisplay pd)
     }
 }
 
+/*
+ * Return the number of requests that shared an existing GC, the number
+ * that created a new one, and the number of shared GCs in use.
+ */
+void
+_XtGetGCStatistics(unsigned long *hits,
+                   unsigned long *misses,
+                   unsigned long *entries)
+{
+    LOCK_PROCESS;
+    *hits = gcStatistics.hits;
+    *misses = gcStatistics.misses;
+    *entries = gcStatistics.entries;
+    UNLOCK_PROCESS;
+}
+
 /*
  * Return a GC with the given values and characteristics.
  */
@@ -193,12 +368,16 @@ XtAllocateGC(register Widget widget,
 {
     register GCptr *prev;
     register GCptr cur;
+    GCptr *bucket;
+    GCTable table;
     Screen *screen;
     register Display *dpy;
     register XtPerDisplay pd;
     Drawable drawable;
     Drawable *pixmaps;
     XtGCMask readOnlyMask;
+    unsigned long hash;
+    int screenNumber;
     GC retval;
 
     WIDGET_TO_APPCON(widget);
@@ -212,35 +391,54 @@ XtAllocateGC(register Widget widget,
     screen = XtScreen(widget);
     dpy = DisplayOfScreen(screen);
     pd = _XtGetPerDisplay(dpy);
+    screenNumber = XScreenNumberOfScreen(screen);
     unusedMask &= ~valueMask;
     readOnlyMask = ~(dynamicMask | unusedMask);
 
-    /* Search for existing GC that matches exactly */
-    for (prev = &pd->GClist; (cur = *prev); prev = &cur->next) {
-        if (cur->depth == depth &&
-            ScreenOfDisplay(dpy, cur->screen) == screen &&
+    table = FindGCTable(pd);
+    if (!table) {
+        table = XtNew(GCTableRec);
+        table->pd = pd;
+        table->size = table->count = 0;
+        table->buckets = table->gcBuckets = NULL;
+        ExpandGCTable(table);
+        table->next = gcTables;
+        gcTables = table;
+    }
+    hash = HashRequest(screenNumber, depth, valueMask, values,
+                       readOnlyMask, dynamicMask);
+
+    /* Search the request's bucket for an existing GC that matches */
+    bucket = &table->buckets[GC_HASH(hash, table->size)];
+    for (prev = bucket; (cur = *prev); prev = &cur->next) {
+        if (cur->hash == hash &&
+            cur->depth == depth &&
+            cur->screen == screenNumber &&
             Matches(dpy, cur, valueMask, values, readOnlyMask, dynamicMask)) {
             cur->ref_count++;
-            /* Move this GC to front of list */
+            /* Move this GC to front of its bucket */
             *prev = cur->next;
-            cur->next = pd->GClist;
-            pd->GClist = cur;
+            cur->next = *bucket;
+            *bucket = cur;
+            gcStatistics.hits++;
             retval = cur->gc;
             UNLOCK_PROCESS;
             UNLOCK_APP(app);
             return retval;
         }
     }
+    gcStatistics.misses++;
 
     /* No matches, have to create a new one */
     cur = XtNew(GCrec);
-    cur->screen = (unsigned char) XScreenNumberOfScreen(screen);
+    cur->screen = (unsigned char) screenNumber;
     cur->depth = (unsigned char) depth;
     cur->ref_count = 1;
     cur->dynamic_mask = dynamicMask;
     cur->unused_mask = (unusedMask & ~dynamicMask);
     cur->dashes = GCVAL(GCDashList, valueMask, values->dashes, 4);
     cur->clip_mask = GCVAL(GCClipMask, valueMask, values->clip_mask, None);
+    cur->hash = hash;
     drawable = 0;
     if (depth == widget->core.depth)
         drawable = XtWindow(widget);
@@ -280,8 +478,16 @@ XtAllocateGC(register Widget widget,
         }
     }
     cur->gc = XCreateGC(dpy, drawable, valueMask, values);
-    cur->next = pd->GClist;
-    pd->GClist = cur;
+    if (table->count >= table->size)
+        ExpandGCTable(table);
+    bucket = &table->buckets[GC_HASH(hash, table->size)];
+    cur->next = *bucket;
+    *bucket = cur;
+    bucket = &table->gcBuckets[GC_ID_HASH(cur->gc, table->size)];
+    cur->gc_next = *bucket;
+    *bucket = cur;
+    table->count++;
+    gcStatistics.entries++;
     retval = cur->gc;
     UNLOCK_PROCESS;
     UNLOCK_APP(app);
@@ -301,9 +507,9 @@ XtGetGC(register Widget widget, XtGCMask valueMask, XGCValues *values)
 void
 XtReleaseGC(Widget widget, register GC gc)
 {
-    register GCptr cur, *prev;
     Display *dpy;
     XtPerDisplay pd;
+    GCTable table;
 
     WIDGET_TO_APPCON(widget);
 
@@ -312,16 +518,9 @@ XtReleaseGC(Widget widget, register GC gc)
     dpy = XtDisplayOfObject(widget);
     pd = _XtGetPerDisplay(dpy);
 
-    for (prev = &pd->GClist; (cur = *prev); prev = &cur->next) {
-        if (cur->gc == gc) {
-            if (--(cur->ref_count) == 0) {
-                *prev = cur->next;
-                XFreeGC(dpy, gc);
-                XtFree((char *) cur);
-            }
-            break;
-        }
-    }
+    table = FindGCTable(pd);
+    if (table)
+        ReleaseGC(dpy, table, gc);
     UNLOCK_PROCESS;
     UNLOCK_APP(app);
 }                               /* XtReleaseGC */
@@ -334,30 +533,22 @@ XtReleaseGC(Widget widget, register GC gc)
 void
 XtDestroyGC(register GC gc)
 {
-    GCptr cur, *prev;
     XtAppContext app;
 
     LOCK_PROCESS;
     app = _XtGetProcessContext()->appContextList;
-    /* This is awful; we have to search through all the lists
+    /* This is awful; we have to search through all the tables
        to find the GC. */
     for (; app; app = app->next) {
         int i;
 
         for (i = app->count; i;) {
             Display *dpy = app->list[--i];
-            XtPerDisplay pd = _XtGetPerDisplay(dpy);
-
-            for (prev = &pd->GClist; (cur = *prev); prev = &cur->next) {
-                if (cur->gc == gc) {
-                    if (--(cur->ref_count) == 0) {
-                        *prev = cur->next;
-                        XFreeGC(dpy, gc);
-                        XtFree((char *) cur);
-                    }
-                    UNLOCK_PROCESS;
-                    return;
-                }
+            GCTable table = FindGCTable(_XtGetPerDisplay(dpy));
+
+            if (table && ReleaseGC(dpy, table, gc)) {
+                UNLOCK_PROCESS;
+                return;
             }
         }
     }
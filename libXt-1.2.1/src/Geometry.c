@@ -94,6 +94,182 @@ ClearRectObjAreas(RectObj r, XWindowChanges *old)
                (unsigned int) (r->rectangle.height + bw2), TRUE);
 }
 
+/*
+ * Geometry transactions.  Between XtBeginGeometryTransaction and the
+ * matching XtCommitGeometryTransaction the window configurations made by
+ * the geometry routines are merged per widget instead of being sent;
+ * the commit sends one ConfigureWindow request for each widget with the
+ * last value of every field that changed, and flushes the display.
+ * Transactions nest; only the outermost commit sends.  Shell windows are
+ * always configured at once, as the shell geometry manager waits for the
+ * window manager's reply.
+ */
+
+typedef struct _PendingConfigureRec {
+    Widget widget;              /* NULL once the widget is destroyed */
+    unsigned int mask;
+    XWindowChanges changes;
+    int next;                   /* next entry in the bucket, or -1 */
+} PendingConfigureRec;
+
+static struct {
+    int depth;
+    PendingConfigureRec *entries;       /* in order of first change */
+    int count;
+    int size;                   /* a power of two */
+    int *buckets;               /* size heads of the hash chains */
+    unsigned long recorded;
+    unsigned long sent;
+} geometryTransaction;
+
+#define PENDING_HASH(w) \
+    ((int) (((unsigned long) (w) >> 4) & (unsigned long) (geometryTransaction.size - 1)))
+
+static void
+ExpandPendingConfigures(void)
+{
+    int i, size = geometryTransaction.size ? geometryTransaction.size * 2 : 64;
+
+    geometryTransaction.entries = (PendingConfigureRec *)
+        XtRealloc((char *) geometryTransaction.entries,
+                  (Cardinal) ((size_t) size * sizeof(PendingConfigureRec)));
+    XtFree((char *) geometryTransaction.buckets);
+    geometryTransaction.buckets = (int *)
+        __XtMalloc((Cardinal) ((size_t) size * sizeof(int)));
+    geometryTransaction.size = size;
+    for (i = 0; i < size; i++)
+        geometryTransaction.buckets[i] = -1;
+    for (i = 0; i < geometryTransaction.count; i++) {
+        PendingConfigureRec *p = geometryTransaction.entries + i;
+
+        if (p->widget) {
+            int h = PENDING_HASH(p->widget);
+
+            p->next = geometryTransaction.buckets[h];
+            geometryTransaction.buckets[h] = i;
+        }
+    }
+}
+
+static PendingConfigureRec *
+FindPendingConfigure(Widget w)
+{
+    int i;
+
+    if (geometryTransaction.size == 0)
+        return NULL;
+    for (i = geometryTransaction.buckets[PENDING_HASH(w)]; i >= 0;
+         i = geometryTransaction.entries[i].next)
+        if (geometryTransaction.entries[i].widget == w)
+            return geometryTransaction.entries + i;
+    return NULL;
+}
+
+static void
+ConfigureWindow(Widget w, unsigned int mask, XWindowChanges *changes)
+{
+    PendingConfigureRec *p;
+
+    LOCK_PROCESS;
+    if (geometryTransaction.depth == 0 || XtIsShell(w)) {
+        UNLOCK_PROCESS;
+        XConfigureWindow(XtDisplay(w), XtWindow(w), mask, changes);
+        return;
+    }
+    geometryTransaction.recorded++;
+    if ((p = FindPendingConfigure(w)) == NULL) {
+        int h;
+
+        if (geometryTransaction.count == geometryTransaction.size)
+            ExpandPendingConfigures();
+        p = geometryTransaction.entries + geometryTransaction.count;
+        h = PENDING_HASH(w);
+        p->widget = w;
+        p->mask = 0;
+        p->next = geometryTransaction.buckets[h];
+        geometryTransaction.buckets[h] = geometryTransaction.count++;
+    }
+    if (mask & CWX)
+        p->changes.x = changes->x;
+    if (mask & CWY)
+        p->changes.y = changes->y;
+    if (mask & CWWidth)
+        p->changes.width = changes->width;
+    if (mask & CWHeight)
+        p->changes.height = changes->height;
+    if (mask & CWBorderWidth)
+        p->changes.border_width = changes->border_width;
+    if (mask & CWStackMode) {
+        p->changes.stack_mode = changes->stack_mode;
+        p->mask &= ~(unsigned) CWSibling;
+        if (mask & CWSibling)
+            p->changes.sibling = changes->sibling;
+    }
+    p->mask |= mask;
+    UNLOCK_PROCESS;
+}
+
+void
+XtBeginGeometryTransaction(void)
+{
+    LOCK_PROCESS;
+    geometryTransaction.depth++;
+    UNLOCK_PROCESS;
+}
+
+void
+XtCommitGeometryTransaction(void)
+{
+    Display *dpy = NULL;
+    int i;
+
+    LOCK_PROCESS;
+    if (geometryTransaction.depth == 0 || --geometryTransaction.depth > 0) {
+        UNLOCK_PROCESS;
+        return;
+    }
+    for (i = 0; i < geometryTransaction.count; i++) {
+        PendingConfigureRec *p = geometryTransaction.entries + i;
+
+        if (p->widget == NULL || !XtIsRealized(p->widget))
+            continue;
+        if (dpy && dpy != XtDisplay(p->widget))
+            XFlush(dpy);
+        dpy = XtDisplay(p->widget);
+        XConfigureWindow(dpy, XtWindow(p->widget), p->mask, &p->changes);
+        geometryTransaction.sent++;
+    }
+    if (dpy)
+        XFlush(dpy);
+    geometryTransaction.count = 0;
+    for (i = 0; i < geometryTransaction.size; i++)
+        geometryTransaction.buckets[i] = -1;
+    UNLOCK_PROCESS;
+}
+
+/* Called from CoreDestroy, as the widget's window dies with it. */
+void
+_XtFlushGeometry(Widget w)
+{
+    PendingConfigureRec *p;
+
+    LOCK_PROCESS;
+    if (geometryTransaction.count && (p = FindPendingConfigure(w)) != NULL)
+        p->widget = NULL;
+    UNLOCK_PROCESS;
+}
+
+void
+_XtGetGeometryStatistics(unsigned long *recorded, unsigned long *sent,
+                         unsigned long *pending)
+{
+    LOCK_PROCESS;
+    *recorded = geometryTransaction.recorded;
+    *sent = geometryTransaction.sent;
+    *pending = (unsigned long) geometryTransaction.count;
+    UNLOCK_PROCESS;
+}
+
 /*
  * Internal function used by XtMakeGeometryRequest and XtSetValues.
  * Returns more data than the public interface.  Does not convert
@@ -463,8 +639,7 @@ _XtMakeGeometryRequest(Widget widget,
         }
 #endif
 
-        XConfigureWindow(XtDisplay(widget), XtWindow(widget),
-                         req.changeMask, &req.changes);
+        ConfigureWindow(widget, req.changeMask, &req.changes);
     }
     else {                      /* RectObj child of realized Widget */
         *clear_rect_obj = TRUE;
@@ -592,8 +767,7 @@ XtResizeWindow(Widget w)
         req.changes.height = w->core.height;
         req.changes.border_width = w->core.border_width;
         req.changeMask = CWWidth | CWHeight | CWBorderWidth;
-        XConfigureWindow(XtDisplay(w), XtWindow(w),
-                         (unsigned) req.changeMask, &req.changes);
+        ConfigureWindow(w, (unsigned) req.changeMask, &req.changes);
         hookobj = XtHooksOfDisplay(XtDisplayOfObject(w));
         if (XtHasCallbacks(hookobj, XtNconfigureHook) == XtCallbackHasSome) {
             req.type = XtHconfigure;
@@ -680,8 +854,7 @@ XtConfigureWidget(Widget w,
                 CALLGEOTAT(_XtGeoTrace(w,
                                        "XConfigure \"%s\"'s window\n",
                                        XtName(w)));
-                XConfigureWindow(XtDisplay(w), XtWindow(w), req.changeMask,
-                                 &req.changes);
+                ConfigureWindow(w, req.changeMask, &req.changes);
             }
             else {
                 CALLGEOTAT(_XtGeoTrace(w,
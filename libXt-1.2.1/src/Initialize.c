@@ -89,6 +89,12 @@ in this Software without prior written authorization from The Open Group.
 #endif
 
 #include <stdlib.h>
+#ifndef WIN32
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #if (defined(SUNSHLIB) || defined(AIXSHLIB)) && defined(SHAREDCODE)
 /*
@@ -388,8 +394,12 @@ GetRootDirName(_XtString dest, int len)
     return dest;
 }
 
-static void
-CombineAppUserDefaults(Display *dpy, XrmDatabase *pdb)
+/*
+ * Returns the name of the file read, to be freed by the caller.
+ */
+static char *
+CombineAppUserDefaults(Display *dpy, XrmDatabase *pdb,
+                       XtFilePredicate predicate)
 {
     char *filename;
     char *path = NULL;
@@ -416,14 +426,14 @@ CombineAppUserDefaults(Display *dpy, XrmDatabase *pdb)
 #endif
     }
 
-    filename = XtResolvePathname(dpy, NULL, NULL, NULL, path, NULL, 0, NULL);
-    if (filename) {
+    filename = XtResolvePathname(dpy, NULL, NULL, NULL, path, NULL, 0,
+                                 predicate);
+    if (filename)
         (void) XrmCombineFileDatabase(filename, pdb, False);
-        XtFree(filename);
-    }
 
     if (deallocate)
         XtFree(path);
+    return filename;
 }
 
 static void
@@ -472,6 +482,509 @@ CopyDB(XrmDatabase db)
     return copy;
 }
 
+/*
+ * Compiled resource cache.  When _XtSetResourceCache has named a cache
+ * file, the resources of the user's and the system app-defaults files
+ * are saved there in binary form, under a key made of everything that
+ * XtResolvePathname substitutes into the search paths.  With them goes
+ * the state of every candidate file tried on the way, and of every file
+ * they pull in with #include: whether it existed, and its modification
+ * time and size.  A later XtScreenDatabase with the same key maps the
+ * cache and, if a single stat of each candidate shows no change, adds
+ * the cached resources without resolving the search paths or parsing
+ * the files.
+ */
+#ifndef WIN32
+
+#define RESOURCE_CACHE_MAGIC 0x43527458         /* "XtRC" */
+#define RESOURCE_CACHE_VERSION 2
+#define MAXCACHEDEPTH 100
+#define MAXINCLUDEDEPTH 100
+
+typedef struct _ProbeRec {
+    char *path;
+    Boolean exists;
+    long long sec, nsec, size;
+} ProbeRec;
+
+static struct {
+    char *filename;
+    ProbeRec *probes;
+    Cardinal num_probes, num_slots;
+    unsigned long hits, misses;
+} resourceCache;
+
+typedef struct _CacheBufferRec {
+    char *data;
+    size_t length, size;
+    unsigned int entries;
+} CacheBufferRec;
+
+typedef struct _CacheCursorRec {
+    const char *data, *end;
+} CacheCursorRec;
+
+void
+_XtSetResourceCache(_Xconst char *filename)
+{
+    LOCK_PROCESS;
+    XtFree(resourceCache.filename);
+    resourceCache.filename = filename ? XtNewString(filename) : NULL;
+    UNLOCK_PROCESS;
+}
+
+void
+_XtGetResourceCacheStatistics(unsigned long *hits, unsigned long *misses)
+{
+    LOCK_PROCESS;
+    *hits = resourceCache.hits;
+    *misses = resourceCache.misses;
+    UNLOCK_PROCESS;
+}
+
+static void
+StatProbe(ProbeRec *probe)
+{
+    struct stat status;
+
+    probe->exists = (stat(probe->path, &status) == 0);
+    probe->sec = probe->exists ? (long long) status.st_mtim.tv_sec : 0;
+    probe->nsec = probe->exists ? (long long) status.st_mtim.tv_nsec : 0;
+    probe->size = probe->exists ? (long long) status.st_size : 0;
+}
+
+static void
+AddProbe(const char *path)
+{
+    ProbeRec *probe;
+    Cardinal i;
+
+    for (i = 0; i < resourceCache.num_probes; i++)
+        if (strcmp(resourceCache.probes[i].path, path) == 0)
+            return;
+    if (resourceCache.num_probes == resourceCache.num_slots) {
+        resourceCache.num_slots += 16;
+        resourceCache.probes = (ProbeRec *)
+            XtRealloc((char *) resourceCache.probes,
+                      (Cardinal) (resourceCache.num_slots * sizeof(ProbeRec)));
+    }
+    probe = &resourceCache.probes[resourceCache.num_probes++];
+    probe->path = XtNewString(path);
+    StatProbe(probe);
+}
+
+static void
+ClearProbes(void)
+{
+    while (resourceCache.num_probes)
+        XtFree(resourceCache.probes[--resourceCache.num_probes].path);
+}
+
+/*
+ * The predicate of XtFindFile while the cache is being filled: records
+ * every candidate tried, the one found included.
+ */
+static Boolean
+RecordProbe(_XtString filename)
+{
+    struct stat status;
+
+    AddProbe(filename);
+    return (access(filename, R_OK) == 0 && stat(filename, &status) == 0 &&
+            !S_ISDIR(status.st_mode));
+}
+
+/*
+ * Records the files that filename includes, and those they include in
+ * turn, read the way Xrm does: a line starting with #include "name",
+ * where a relative name is taken from the directory of the including file.
+ * A file that is already being read further up, under whatever name, is
+ * not read again.
+ */
+typedef struct _IncludeChainRec {
+    struct _IncludeChainRec *up;
+    dev_t dev;
+    ino_t ino;
+    int depth;
+} IncludeChainRec;
+
+static void
+RecordIncludes(const char *filename, IncludeChainRec *up)
+{
+    char line[BUFSIZ];
+    Boolean start = True;
+    IncludeChainRec chain, *c;
+    struct stat status;
+    FILE *file;
+
+    if (up && up->depth >= MAXINCLUDEDEPTH)
+        return;
+    if ((file = fopen(filename, "r")) == NULL)
+        return;
+    if (fstat(fileno(file), &status) != 0) {
+        fclose(file);
+        return;
+    }
+    for (c = up; c; c = c->up)
+        if (c->dev == status.st_dev && c->ino == status.st_ino) {
+            fclose(file);
+            return;
+        }
+    chain.up = up;
+    chain.dev = status.st_dev;
+    chain.ino = status.st_ino;
+    chain.depth = up ? up->depth + 1 : 1;
+    while (fgets(line, (int) sizeof(line), file)) {
+        char *s = line, *name, *end, *path;
+        const char *slash;
+        Boolean at_start = start;
+
+        start = (strchr(line, '\n') != NULL);
+        if (!at_start)
+            continue;
+        while (*s == ' ' || *s == '\t')
+            s++;
+        if (*s++ != '#')
+            continue;
+        while (*s == ' ' || *s == '\t')
+            s++;
+        if (strncmp(s, "include", 7) != 0)
+            continue;
+        s += 7;
+        while (*s == ' ' || *s == '\t')
+            s++;
+        if (*s != '"' || !(end = strchr(name = s + 1, '"')))
+            continue;
+        *end = '\0';
+        if (*name != '/' && (slash = strrchr(filename, '/')))
+            XtAsprintf(&path, "%.*s/%s", (int) (slash - filename), filename,
+                       name);
+        else
+            path = XtNewString(name);
+        AddProbe(path);
+        RecordIncludes(path, &chain);
+        XtFree(path);
+    }
+    fclose(file);
+}
+
+static char *
+ResourceCacheKey(Display *dpy)
+{
+    XtPerDisplay pd = _XtGetPerDisplay(dpy);
+    const char *vars[] = { "XUSERFILESEARCHPATH", "XAPPLRESDIR",
+                           "XFILESEARCHPATH" };
+    char homedir[PATH_MAX];
+    XrmName name_list[3];
+    XrmClass class_list[3];
+    XrmRepresentation type;
+    XrmValue value;
+    const char *customization = "";
+    const char *env[3];
+    char *key;
+    int i;
+
+    name_list[0] = pd->name;
+    name_list[1] = XrmPermStringToQuark("customization");
+    name_list[2] = NULLQUARK;
+    class_list[0] = pd->class;
+    class_list[1] = XrmPermStringToQuark("Customization");
+    class_list[2] = NULLQUARK;
+    if (XrmQGetResource(XrmGetDatabase(dpy), name_list, class_list,
+                        &type, &value) && type == XrmPermStringToQuark(XtRString))
+        customization = (const char *) value.addr;
+    for (i = 0; i < 3; i++)
+        if (!(env[i] = getenv(vars[i])))
+            env[i] = "";
+    (void) GetRootDirName(homedir, PATH_MAX);
+    XtAsprintf(&key, "%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s",
+               XrmQuarkToString(pd->name), XrmQuarkToString(pd->class),
+               pd->language ? pd->language : "", customization,
+               env[0], env[1], env[2], homedir);
+    return key;
+}
+
+static void
+PutCacheData(CacheBufferRec *buffer, const void *data, size_t length)
+{
+    if (buffer->length + length > buffer->size) {
+        while (buffer->length + length > buffer->size)
+            buffer->size = buffer->size ? buffer->size << 1 : 4096;
+        buffer->data = XtRealloc(buffer->data, (Cardinal) buffer->size);
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+}
+
+static void
+PutCacheInt(CacheBufferRec *buffer, unsigned int n)
+{
+    PutCacheData(buffer, &n, sizeof(n));
+}
+
+static void
+PutCacheString(CacheBufferRec *buffer, const char *string)
+{
+    unsigned int length = (unsigned int) strlen(string) + 1;
+
+    PutCacheInt(buffer, length);
+    PutCacheData(buffer, string, length);
+}
+
+static Bool
+PutCacheEntry(XrmDatabase *db _X_UNUSED,
+              XrmBindingList bindings,
+              XrmQuarkList quarks,
+              XrmRepresentation *type,
+              XrmValuePtr value,
+              XPointer data)
+{
+    CacheBufferRec *buffer = (CacheBufferRec *) data;
+    unsigned int i, n;
+    unsigned char binding;
+
+    for (n = 0; quarks[n] != NULLQUARK; n++);
+    PutCacheInt(buffer, n);
+    for (i = 0; i < n; i++) {
+        binding = (unsigned char) bindings[i];
+        PutCacheData(buffer, &binding, 1);
+        PutCacheString(buffer, XrmQuarkToString(quarks[i]));
+    }
+    PutCacheString(buffer, XrmQuarkToString(*type));
+    PutCacheInt(buffer, value->size);
+    PutCacheData(buffer, value->addr, value->size);
+    buffer->entries++;
+    return False;
+}
+
+static Boolean
+GetCacheData(CacheCursorRec *cursor, void *data, size_t length)
+{
+    if ((size_t) (cursor->end - cursor->data) < length)
+        return False;
+    memcpy(data, cursor->data, length);
+    cursor->data += length;
+    return True;
+}
+
+static const char *
+GetCacheString(CacheCursorRec *cursor)
+{
+    const char *string;
+    unsigned int length;
+
+    if (!GetCacheData(cursor, &length, sizeof(length)) || length == 0 ||
+        (size_t) (cursor->end - cursor->data) < length ||
+        cursor->data[length - 1] != '\0')
+        return NULL;
+    string = cursor->data;
+    cursor->data += length;
+    return string;
+}
+
+/*
+ * Save db, the resources parsed from files, under key.
+ */
+static void
+SaveResourceCache(const char *key, char *files[], Cardinal num_files,
+                  XrmDatabase db, Status do_fallback)
+{
+    XrmQuark empty = NULLQUARK;
+    CacheBufferRec buffer = { NULL, 0, 0, 0 };
+    size_t count_offset;
+    char *temporary;
+    Cardinal i;
+    int fd;
+
+    for (i = 0; i < num_files; i++)
+        if (files[i])
+            RecordIncludes(files[i], NULL);
+
+    PutCacheInt(&buffer, RESOURCE_CACHE_MAGIC);
+    PutCacheInt(&buffer, RESOURCE_CACHE_VERSION);
+    PutCacheString(&buffer, key);
+    PutCacheInt(&buffer, (unsigned int) do_fallback);
+    PutCacheInt(&buffer, resourceCache.num_probes);
+    for (i = 0; i < resourceCache.num_probes; i++) {
+        ProbeRec *probe = &resourceCache.probes[i];
+        unsigned char exists = probe->exists;
+
+        PutCacheString(&buffer, probe->path);
+        PutCacheData(&buffer, &exists, 1);
+        PutCacheData(&buffer, &probe->sec, sizeof(probe->sec));
+        PutCacheData(&buffer, &probe->nsec, sizeof(probe->nsec));
+        PutCacheData(&buffer, &probe->size, sizeof(probe->size));
+    }
+    count_offset = buffer.length;
+    PutCacheInt(&buffer, 0);
+    if (db) {
+        XrmEnumerateDatabase(db, &empty, &empty, XrmEnumAllLevels,
+                             PutCacheEntry, (XPointer) &buffer);
+        memcpy(buffer.data + count_offset, &buffer.entries,
+               sizeof(buffer.entries));
+    }
+
+    /*
+     * Write a new file and rename it, so readers never see a partial one.
+     * mkstemp creates it, so a link planted under its name is not followed.
+     */
+    XtAsprintf(&temporary, "%s.XXXXXX", resourceCache.filename);
+    fd = mkstemp(temporary);
+    if (fd >= 0) {
+        Boolean written =
+            (write(fd, buffer.data, buffer.length) == (ssize_t) buffer.length);
+
+        if (close(fd) == 0 && written)
+            (void) rename(temporary, resourceCache.filename);
+        else
+            (void) unlink(temporary);
+    }
+    XtFree(temporary);
+    XtFree(buffer.data);
+}
+
+/*
+ * Add the cached resources for key to *pdb.  Returns False if there is
+ * no cache for key, or if a file or directory it depends on has changed.
+ */
+static Boolean
+LoadResourceCache(const char *key, XrmDatabase *pdb, Status *do_fallback)
+{
+    CacheCursorRec cursor;
+    XrmDatabase db = NULL;
+    XrmBinding bindings[MAXCACHEDEPTH];
+    XrmQuark quarks[MAXCACHEDEPTH + 1];
+    struct stat status;
+    const char *string;
+    unsigned int magic, version, fallback, num_probes, num_entries, i, j, n;
+    Boolean valid = False;
+    void *map;
+    int fd;
+
+    if ((fd = open(resourceCache.filename, O_RDONLY)) < 0)
+        return False;
+    if (fstat(fd, &status) != 0 || status.st_size == 0 ||
+        (map = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE,
+                    fd, 0)) == MAP_FAILED) {
+        close(fd);
+        return False;
+    }
+    close(fd);
+    cursor.data = (const char *) map;
+    cursor.end = cursor.data + status.st_size;
+
+    if (!GetCacheData(&cursor, &magic, sizeof(magic)) ||
+        magic != RESOURCE_CACHE_MAGIC ||
+        !GetCacheData(&cursor, &version, sizeof(version)) ||
+        version != RESOURCE_CACHE_VERSION ||
+        !(string = GetCacheString(&cursor)) || strcmp(string, key) != 0 ||
+        !GetCacheData(&cursor, &fallback, sizeof(fallback)) ||
+        !GetCacheData(&cursor, &num_probes, sizeof(num_probes)))
+        goto done;
+    for (i = 0; i < num_probes; i++) {
+        ProbeRec cached, current;
+        unsigned char exists;
+
+        if (!(string = GetCacheString(&cursor)) ||
+            !GetCacheData(&cursor, &exists, 1) ||
+            !GetCacheData(&cursor, &cached.sec, sizeof(cached.sec)) ||
+            !GetCacheData(&cursor, &cached.nsec, sizeof(cached.nsec)) ||
+            !GetCacheData(&cursor, &cached.size, sizeof(cached.size)))
+            goto done;
+        current.path = (char *) string;
+        StatProbe(&current);
+        if (current.exists != (Boolean) exists || current.sec != cached.sec ||
+            current.nsec != cached.nsec || current.size != cached.size)
+            goto done;
+    }
+    if (!GetCacheData(&cursor, &num_entries, sizeof(num_entries)))
+        goto done;
+    for (i = 0; i < num_entries; i++) {
+        XrmValue value;
+        XrmRepresentation type;
+
+        if (!GetCacheData(&cursor, &n, sizeof(n)) || n == 0 ||
+            n > MAXCACHEDEPTH)
+            goto done;
+        for (j = 0; j < n; j++) {
+            unsigned char binding;
+
+            if (!GetCacheData(&cursor, &binding, 1) ||
+                !(string = GetCacheString(&cursor)))
+                goto done;
+            bindings[j] = (XrmBinding) binding;
+            quarks[j] = XrmStringToQuark(string);
+        }
+        quarks[n] = NULLQUARK;
+        if (!(string = GetCacheString(&cursor)) ||
+            !GetCacheData(&cursor, &value.size, sizeof(value.size)) ||
+            (size_t) (cursor.end - cursor.data) < value.size)
+            goto done;
+        type = XrmStringToRepresentation(string);
+        value.addr = (XPointer) cursor.data;
+        cursor.data += value.size;
+        XrmQPutResource(&db, bindings, quarks, type, &value);
+    }
+    valid = True;
+    *do_fallback = (Status) fallback;
+
+ done:
+    munmap(map, (size_t) status.st_size);
+    if (valid && db)
+        XrmCombineDatabase(db, pdb, False);
+    else if (db)
+        XrmDestroyDatabase(db);
+    return valid;
+}
+
+#endif                          /* WIN32 */
+
+/*
+ * The user's and the system app-defaults files, in that order.  Returns
+ * whether the fallback resources are needed.
+ */
+static Status
+CombineAppDefaults(Display *dpy, XrmDatabase *pdb)
+{
+    Status do_fallback = 1;
+    XtFilePredicate predicate = NULL;
+    XrmDatabase db = NULL;
+    XrmDatabase *target = pdb;
+    char *files[2];
+    char *key = NULL;
+
+#ifndef WIN32
+    if (resourceCache.filename) {
+        key = ResourceCacheKey(dpy);
+        if (LoadResourceCache(key, pdb, &do_fallback)) {
+            resourceCache.hits++;
+            XtFree(key);
+            return do_fallback;
+        }
+        resourceCache.misses++;
+        predicate = RecordProbe;
+        /* Parse into a database of its own, to save it before adding it. */
+        target = &db;
+    }
+#endif
+    files[0] = CombineAppUserDefaults(dpy, target, predicate);
+    if ((files[1] = XtResolvePathname(dpy, "app-defaults",
+                                      NULL, NULL, NULL, NULL, 0, predicate)))
+        do_fallback = !XrmCombineFileDatabase(files[1], target, False);
+#ifndef WIN32
+    if (key) {
+        SaveResourceCache(key, files, 2, db, do_fallback);
+        ClearProbes();
+        XtFree(key);
+        if (db)
+            XrmCombineDatabase(db, pdb, False);
+    }
+#endif
+    XtFree(files[0]);
+    XtFree(files[1]);
+    return do_fallback;
+}
+
 static String
 _XtDefaultLanguageProc(Display *dpy _X_UNUSED,
                        String xnl,
@@ -614,17 +1127,8 @@ XtScreenDatabase(Screen *screen)
     olddb = XrmGetDatabase(dpy);
     /* set database now, for XtResolvePathname to use */
     XrmSetDatabase(dpy, db);
-    CombineAppUserDefaults(dpy, &db);
-    do_fallback = 1;
-    {                           /* System app-defaults */
-        char *filename;
-
-        if ((filename = XtResolvePathname(dpy, "app-defaults",
-                                          NULL, NULL, NULL, NULL, 0, NULL))) {
-            do_fallback = !XrmCombineFileDatabase(filename, &db, False);
-            XtFree(filename);
-        }
-    }
+    /* User and system app-defaults */
+    do_fallback = CombineAppDefaults(dpy, &db);
     /* now restore old database, if need be */
     if (!doing_def)
         XrmSetDatabase(dpy, olddb);
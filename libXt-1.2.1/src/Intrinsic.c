@@ -522,6 +522,282 @@ static Widget NameListToWidget(Widget root,
                                XrmBindingList bindings,
                                int in_depth, int *out_depth, int *found_depth);
 
+/*
+ * Composites with many children get an index from child name to the
+ * children with that name, in the order of their children array, built
+ * the first time a tight name is matched against them.  A child inserted
+ * at the end of the array is appended to the index; any other insertion
+ * or deletion drops the index, to be rebuilt on the next lookup.  Popups
+ * are few and are still searched linearly.
+ *
+ * Complete lookups are memoized in a small direct-mapped cache keyed by
+ * root widget and name.  Every change to the widget tree bumps a
+ * generation count, which invalidates all of its entries at once.
+ */
+#define MINNAMEINDEX 8
+#define PATHCACHESIZE 256
+
+typedef struct _NameIndexEntryRec {
+    struct _NameIndexEntryRec *next;
+    XrmName name;
+    Cardinal num_children;
+    Cardinal num_slots;
+    WidgetList children;
+} NameIndexEntryRec, *NameIndexEntry;
+
+typedef struct _NameIndexRec {
+    struct _NameIndexRec *next;
+    Widget parent;
+    Cardinal size;                      /* a power of two */
+    Cardinal count;                     /* distinct names */
+    NameIndexEntry *buckets;
+} NameIndexRec, *NameIndex;
+
+static struct {
+    NameIndex *buckets;
+    Cardinal size;                      /* a power of two */
+    Cardinal count;
+    unsigned long generation;
+} nameIndexes;
+
+typedef struct _PathCacheRec {
+    Widget root;
+    unsigned long generation;
+    String name;
+    Widget result;
+} PathCacheRec;
+
+static PathCacheRec pathCache[PATHCACHESIZE];
+static unsigned long pathCacheHits, pathCacheMisses;
+
+#define NAME_INDEX_HASH(parent, size) \
+    ((Cardinal) (((unsigned long) (parent) >> 4) & ((size) - 1)))
+
+static NameIndex *
+FindNameIndex(Widget parent)
+{
+    NameIndex *prev;
+
+    if (nameIndexes.size == 0)
+        return NULL;
+    for (prev = &nameIndexes.buckets[NAME_INDEX_HASH(parent,
+                                                     nameIndexes.size)];
+         *prev; prev = &(*prev)->next)
+        if ((*prev)->parent == parent)
+            return prev;
+    return NULL;
+}
+
+static void
+FreeNameIndex(NameIndex ni)
+{
+    NameIndexEntry e, next;
+    Cardinal i;
+
+    for (i = 0; i < ni->size; i++) {
+        for (e = ni->buckets[i]; e; e = next) {
+            next = e->next;
+            XtFree((char *) e->children);
+            XtFree((char *) e);
+        }
+    }
+    XtFree((char *) ni->buckets);
+    XtFree((char *) ni);
+}
+
+static void
+IndexChild(NameIndex ni, Widget child)
+{
+    NameIndexEntry e, next, *buckets;
+    XrmName name = child->core.xrm_name;
+    Cardinal i, j, size;
+
+    for (e = ni->buckets[NAME_INDEX_HASH(name, ni->size)]; e; e = e->next)
+        if (e->name == name)
+            break;
+    if (e == NULL) {
+        if (ni->count >= ni->size) {
+            size = ni->size << 1;
+            buckets = (NameIndexEntry *)
+                __XtCalloc(size, (Cardinal) sizeof(NameIndexEntry));
+            for (i = 0; i < ni->size; i++) {
+                for (e = ni->buckets[i]; e; e = next) {
+                    next = e->next;
+                    j = NAME_INDEX_HASH(e->name, size);
+                    e->next = buckets[j];
+                    buckets[j] = e;
+                }
+            }
+            XtFree((char *) ni->buckets);
+            ni->buckets = buckets;
+            ni->size = size;
+        }
+        e = XtNew(NameIndexEntryRec);
+        e->name = name;
+        e->num_children = e->num_slots = 0;
+        e->children = NULL;
+        i = NAME_INDEX_HASH(name, ni->size);
+        e->next = ni->buckets[i];
+        ni->buckets[i] = e;
+        ni->count++;
+    }
+    if (e->num_children == e->num_slots) {
+        e->num_slots = e->num_slots ? e->num_slots << 1 : 1;
+        e->children = (WidgetList)
+            XtRealloc((char *) e->children,
+                      (Cardinal) (e->num_slots * sizeof(Widget)));
+    }
+    e->children[e->num_children++] = child;
+}
+
+static NameIndex
+BuildNameIndex(CompositeWidget cw)
+{
+    NameIndex ni;
+    Cardinal i, j, size;
+    NameIndex *buckets;
+
+    if (nameIndexes.count >= nameIndexes.size) {
+        size = nameIndexes.size ? nameIndexes.size << 1 : 64;
+        buckets = (NameIndex *) __XtCalloc(size, (Cardinal) sizeof(NameIndex));
+        for (i = 0; i < nameIndexes.size; i++) {
+            while ((ni = nameIndexes.buckets[i])) {
+                nameIndexes.buckets[i] = ni->next;
+                j = NAME_INDEX_HASH(ni->parent, size);
+                ni->next = buckets[j];
+                buckets[j] = ni;
+            }
+        }
+        XtFree((char *) nameIndexes.buckets);
+        nameIndexes.buckets = buckets;
+        nameIndexes.size = size;
+    }
+    ni = XtNew(NameIndexRec);
+    ni->parent = (Widget) cw;
+    ni->count = 0;
+    for (ni->size = 16; ni->size < cw->composite.num_children; ni->size <<= 1);
+    ni->buckets = (NameIndexEntry *)
+        __XtCalloc(ni->size, (Cardinal) sizeof(NameIndexEntry));
+    for (i = 0; i < cw->composite.num_children; i++)
+        IndexChild(ni, cw->composite.children[i]);
+    i = NAME_INDEX_HASH(cw, nameIndexes.size);
+    ni->next = nameIndexes.buckets[i];
+    nameIndexes.buckets[i] = ni;
+    nameIndexes.count++;
+    return ni;
+}
+
+/* Drop the child name index of parent, which is being destroyed. */
+void
+_XtFlushNameIndex(Widget parent)
+{
+    NameIndex *prev, ni;
+
+    LOCK_PROCESS;
+    if (nameIndexes.count && (prev = FindNameIndex(parent))) {
+        ni = *prev;
+        *prev = ni->next;
+        FreeNameIndex(ni);
+        nameIndexes.count--;
+    }
+    UNLOCK_PROCESS;
+}
+
+/* Called when child has been added to its parent's children or popups. */
+void
+_XtIndexChildInserted(Widget child)
+{
+    Widget parent = child->core.parent;
+    NameIndex *prev;
+
+    LOCK_PROCESS;
+    nameIndexes.generation++;
+    if (nameIndexes.count && parent && (prev = FindNameIndex(parent))) {
+        CompositeWidget cw = (CompositeWidget) parent;
+        Cardinal n = cw->composite.num_children;
+
+        if (n && cw->composite.children[n - 1] == child)
+            IndexChild(*prev, child);
+        else if (!(parent->core.num_popups &&
+                   parent->core.popup_list[parent->core.num_popups - 1] ==
+                   child)) {
+            UNLOCK_PROCESS;
+            _XtFlushNameIndex(parent);
+            return;
+        }
+    }
+    UNLOCK_PROCESS;
+}
+
+/*
+ * Called once a destroyed subtree has been freed, since lookups made by
+ * its destroy callbacks may have cached widgets in it.
+ */
+void
+_XtInvalidateNameCache(void)
+{
+    LOCK_PROCESS;
+    nameIndexes.generation++;
+    UNLOCK_PROCESS;
+}
+
+/* Called when child is taken out of its parent's children or popups. */
+void
+_XtIndexChildDeleted(Widget child)
+{
+    LOCK_PROCESS;
+    nameIndexes.generation++;
+    UNLOCK_PROCESS;
+    if (child->core.parent)
+        _XtFlushNameIndex(child->core.parent);
+}
+
+/*
+ * The children of the composite root named name, in the order of its
+ * children array.  Returns False if root is too small to be indexed.
+ */
+static Boolean
+IndexedChildren(Widget root, XrmName name,
+                WidgetList *children, Cardinal *num_children)
+{
+    CompositeWidget cw = (CompositeWidget) root;
+    NameIndex *prev, ni;
+    NameIndexEntry e;
+
+    if (cw->composite.num_children < MINNAMEINDEX)
+        return False;
+    LOCK_PROCESS;
+    ni = (prev = FindNameIndex(root)) ? *prev : BuildNameIndex(cw);
+    for (e = ni->buckets[NAME_INDEX_HASH(name, ni->size)]; e; e = e->next)
+        if (e->name == name)
+            break;
+    UNLOCK_PROCESS;
+    *children = e ? e->children : NULL;
+    *num_children = e ? e->num_children : 0;
+    return True;
+}
+
+static PathCacheRec *
+PathCacheSlot(Widget root, _Xconst char *name)
+{
+    unsigned long h = (unsigned long) root >> 4;
+
+    while (*name)
+        h = (h ^ (unsigned char) *name++) * 16777619;
+    return &pathCache[h & (PATHCACHESIZE - 1)];
+}
+
+void
+_XtGetNameCacheStatistics(unsigned long *hits, unsigned long *misses,
+                          unsigned long *indexes)
+{
+    LOCK_PROCESS;
+    *hits = pathCacheHits;
+    *misses = pathCacheMisses;
+    *indexes = nameIndexes.count;
+    UNLOCK_PROCESS;
+}
+
 typedef Widget(*NameMatchProc) (XrmNameList,
                                 XrmBindingList,
                                 WidgetList, Cardinal, int, int *, int *);
@@ -592,9 +868,13 @@ SearchChildren(Widget root,
     int d1, d2;
 
     if (XtIsComposite(root)) {
-        w1 = (*matchproc) (names, bindings,
-                           ((CompositeWidget) root)->composite.children,
-                           ((CompositeWidget) root)->composite.num_children,
+        WidgetList children = ((CompositeWidget) root)->composite.children;
+        Cardinal num_children =
+            ((CompositeWidget) root)->composite.num_children;
+
+        if (matchproc == MatchExactChildren)
+            (void) IndexedChildren(root, *names, &children, &num_children);
+        w1 = (*matchproc) (names, bindings, children, num_children,
                            in_depth, &d1, found_depth);
     }
     else
@@ -654,6 +934,7 @@ XtNameToWidget(Widget root, _Xconst char *name)
     XrmBinding *bindings;
     int len, depth, found = 10000;
     Widget result;
+    PathCacheRec *slot;
 
     WIDGET_TO_APPCON(root);
 
@@ -662,6 +943,18 @@ XtNameToWidget(Widget root, _Xconst char *name)
         return NULL;
 
     LOCK_APP(app);
+    LOCK_PROCESS;
+    slot = PathCacheSlot(root, name);
+    if (slot->root == root && slot->generation == nameIndexes.generation &&
+        strcmp(slot->name, name) == 0) {
+        pathCacheHits++;
+        result = slot->result;
+        UNLOCK_PROCESS;
+        UNLOCK_APP(app);
+        return result;
+    }
+    pathCacheMisses++;
+    UNLOCK_PROCESS;
     names = (XrmName *) ALLOCATE_LOCAL((unsigned) (len + 1) * sizeof(XrmName));
     bindings = (XrmBinding *)
         ALLOCATE_LOCAL((unsigned) (len + 1) * sizeof(XrmBinding));
@@ -678,6 +971,14 @@ XtNameToWidget(Widget root, _Xconst char *name)
 
     result = NameListToWidget(root, names, bindings, 0, &depth, &found);
 
+    LOCK_PROCESS;
+    XtFree(slot->name);
+    slot->name = XtNewString(name);
+    slot->root = root;
+    slot->generation = nameIndexes.generation;
+    slot->result = result;
+    UNLOCK_PROCESS;
+
     DEALLOCATE_LOCAL((char *) bindings);
     DEALLOCATE_LOCAL((char *) names);
     UNLOCK_APP(app);
@@ -83,6 +83,7 @@ typedef long suseconds_t;
 static TimerEventRec *freeTimerRecs;
 static WorkProcRec *freeWorkRecs;
 static SignalEventRec *freeSignalRecs;
+static InputEvent *freeInputRecs;
 
 /* Some systems running NTP daemons are known to return strange usec
  * values from gettimeofday.
@@ -1053,7 +1054,15 @@ XtAppAddInput(XtAppContext app,
             app->input_list[ii] = (InputEvent *) NULL;
         app->input_max = (short) n;
     }
-    sptr = XtNew(InputEvent);
+    LOCK_PROCESS;
+    if (freeInputRecs) {
+        sptr = freeInputRecs;
+        freeInputRecs = sptr->ie_next;
+    }
+    else
+        sptr = XtNew(InputEvent);
+
+    UNLOCK_PROCESS;
 
     sptr->ie_proc = proc;
     sptr->ie_closure = closure;
@@ -1130,7 +1139,10 @@ XtRemoveInput(register XtInputId id)
                     !(condition & XtInputExceptMask))
                     FD_CLR(source, &app->fds.emask);
 #endif
-                XtFree((char *) sptr);
+                LOCK_PROCESS;
+                sptr->ie_next = freeInputRecs;
+                freeInputRecs = sptr;
+                UNLOCK_PROCESS;
                 found = True;
                 break;
             }
@@ -1164,7 +1176,10 @@ _XtRemoveAllInputs(XtAppContext app)
         while (ep) {
             InputEvent *next = ep->ie_next;
 
-            XtFree((char *) ep);
+            LOCK_PROCESS;
+            ep->ie_next = freeInputRecs;
+            freeInputRecs = ep;
+            UNLOCK_PROCESS;
             ep = next;
         }
     }
@@ -1267,6 +1282,8 @@ XtNextEvent(XEvent *event)
     XtAppNextEvent(_XtDefaultAppContext(), event);
 }
 
+extern unsigned long _XtMatchTableGeneration;   /* from TMstate.c */
+
 void
 _XtRefreshMapping(XEvent *event, _XtBoolean dispatch)
 {
@@ -1274,6 +1291,7 @@ _XtRefreshMapping(XEvent *event, _XtBoolean dispatch)
 
     LOCK_PROCESS;
     pd = _XtGetPerDisplay(event->xmapping.display);
+    _XtMatchTableGeneration++;
 
     if (event->xmapping.request != MappingPointer &&
         pd && pd->keysyms && (event->xmapping.serial >= pd->keysyms_serial))
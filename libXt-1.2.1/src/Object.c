@@ -86,6 +86,8 @@ static void ObjectClassPartInitialize(WidgetClass);
 static Boolean ObjectSetValues(Widget, Widget, Widget, ArgList, Cardinal *);
 static void ObjectDestroy(Widget);
 
+extern void _XtFlushSetValues(Widget);  /* from SetValues.c */
+
 /* *INDENT-OFF* */
 externaldef(objectclassrec) ObjectClassRec objectClassRec = {
   {
@@ -295,6 +297,8 @@ ObjectDestroy(register Widget widget)
     CallbackTable offsets;
     int i;
 
+    _XtFlushSetValues(widget);
+
     /* Remove all callbacks associated with widget */
     LOCK_PROCESS;
     offsets = (CallbackTable)
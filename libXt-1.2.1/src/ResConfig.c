@@ -73,6 +73,8 @@ static void _set_and_search(Widget, char *, char *, char *, char *, char,
                             char *);
 static int _locate_children(Widget, Widget **);
 
+void _XtDatabaseChanged(XrmDatabase);   /* from Resources.c */
+
 /*
  * NAME: _set_resource_values
  *
@@ -247,6 +249,7 @@ _set_resource_values(Widget w, char *resource, char *value, char *last_part)
      */
     XrmPutStringResource(&db, resource, value);
     XrmMergeDatabases(db, &tmp_db);
+    _XtDatabaseChanged(tmp_db);
     XrmGetResource(tmp_db, resource_name, resource_class,
                    &return_type, &return_value);
     if (return_type)
@@ -468,6 +468,265 @@ _XtCreateIndirectionTable(XtResourceList resources, Cardinal num_resources)
     return table;
 }
 
+/*
+ * Search lists are cached per parent, keyed by the name and class of the
+ * child and the database they were taken from, so that creating many
+ * children with the same name and class walks the database only once.
+ * Each parent keeps its most recently used lists, at most
+ * MAXPARENTSEARCHLISTS of them.  The lists of a parent are dropped when
+ * it is destroyed, and all lists are dropped when a display, and with it
+ * its databases, is closed.  A database changed in place, as ResConfig
+ * does, is given a new stamp through _XtDatabaseChanged, and a cached
+ * list is only used while its database still has the stamp it was taken
+ * with.  An application that changes a database in place through Xrm
+ * after widgets were created should call _XtDatabaseChanged as well.
+ */
+#define MAXPARENTSEARCHLISTS 16
+
+typedef struct _SearchListRec {
+    struct _SearchListRec *next;        /* less recently used */
+    XrmName name;
+    XrmClass class;
+    XrmDatabase db;
+    unsigned long stamp;                /* of db when the list was taken */
+    unsigned int length;                /* including the NULL terminator */
+    XrmHashTable list[1];               /* variable length */
+} SearchListRec, *SearchList;
+
+typedef struct _ParentSearchListsRec {
+    struct _ParentSearchListsRec *next;
+    Widget parent;
+    Cardinal count;
+    SearchList lists;                   /* most recently used first */
+} ParentSearchListsRec, *ParentSearchLists;
+
+static struct {
+    ParentSearchLists *buckets;
+    Cardinal size;                      /* a power of two */
+    Cardinal count;
+} searchLists;
+
+#define SEARCH_LIST_HASH(parent, size) \
+    ((Cardinal) (((unsigned long) (parent) >> 4) & ((size) - 1)))
+
+/* Databases that were changed in place, with their latest stamp */
+typedef struct {
+    XrmDatabase db;
+    unsigned long stamp;
+} DatabaseStampRec;
+
+static struct {
+    DatabaseStampRec *stamps;
+    Cardinal count;
+    Cardinal size;
+    unsigned long last;                 /* last stamp handed out */
+} databaseStamps;
+
+void _XtFlushSearchLists(Widget);
+void _XtDatabaseChanged(XrmDatabase);
+
+/* Called with the process lock held */
+static unsigned long
+DatabaseStamp(XrmDatabase db)
+{
+    Cardinal i;
+
+    for (i = 0; i < databaseStamps.count; i++)
+        if (databaseStamps.stamps[i].db == db)
+            return databaseStamps.stamps[i].stamp;
+    return 0;
+}
+
+/*
+ * Note that db was changed in place, so that the search lists cached for
+ * it are no longer used.
+ */
+void
+_XtDatabaseChanged(XrmDatabase db)
+{
+    Cardinal i;
+
+    LOCK_PROCESS;
+    for (i = 0; i < databaseStamps.count; i++)
+        if (databaseStamps.stamps[i].db == db)
+            break;
+    if (i == databaseStamps.count) {
+        if (databaseStamps.count == databaseStamps.size) {
+            databaseStamps.size += 4;
+            databaseStamps.stamps = (DatabaseStampRec *)
+                XtRealloc((char *) databaseStamps.stamps,
+                          (Cardinal) (databaseStamps.size *
+                                      sizeof(DatabaseStampRec)));
+        }
+        databaseStamps.stamps[databaseStamps.count++].db = db;
+    }
+    databaseStamps.stamps[i].stamp = ++databaseStamps.last;
+    UNLOCK_PROCESS;
+}
+
+static void
+FreeParentSearchLists(ParentSearchLists ps)
+{
+    SearchList sl, next;
+
+    for (sl = ps->lists; sl; sl = next) {
+        next = sl->next;
+        XtFree((char *) sl);
+    }
+    XtFree((char *) ps);
+}
+
+/*
+ * Drop the search lists cached for the children of parent, or all the
+ * cached search lists if parent is NULL.
+ */
+void
+_XtFlushSearchLists(Widget parent)
+{
+    ParentSearchLists ps, *prev;
+    Cardinal i;
+
+    LOCK_PROCESS;
+    if (parent == NULL) {
+        for (i = 0; i < searchLists.size; i++) {
+            while ((ps = searchLists.buckets[i])) {
+                searchLists.buckets[i] = ps->next;
+                FreeParentSearchLists(ps);
+            }
+        }
+        searchLists.count = 0;
+        /* No list refers to a database any more, and they may be freed */
+        databaseStamps.count = 0;
+    }
+    else if (searchLists.count) {
+        for (prev = &searchLists.buckets[SEARCH_LIST_HASH(parent,
+                                                          searchLists.size)];
+             (ps = *prev); prev = &ps->next) {
+            if (ps->parent == parent) {
+                *prev = ps->next;
+                FreeParentSearchLists(ps);
+                searchLists.count--;
+                break;
+            }
+        }
+    }
+    UNLOCK_PROCESS;
+}
+
+static ParentSearchLists
+FindParentSearchLists(Widget parent, Boolean create)
+{
+    ParentSearchLists ps, *buckets;
+    Cardinal i, j, size;
+
+    if (searchLists.size) {
+        for (ps = searchLists.buckets[SEARCH_LIST_HASH(parent,
+                                                       searchLists.size)];
+             ps; ps = ps->next)
+            if (ps->parent == parent)
+                return ps;
+    }
+    if (!create)
+        return NULL;
+    if (searchLists.count >= searchLists.size) {
+        size = searchLists.size ? searchLists.size << 1 : 64;
+        buckets = (ParentSearchLists *)
+            __XtCalloc(size, (Cardinal) sizeof(ParentSearchLists));
+        for (i = 0; i < searchLists.size; i++) {
+            while ((ps = searchLists.buckets[i])) {
+                searchLists.buckets[i] = ps->next;
+                j = SEARCH_LIST_HASH(ps->parent, size);
+                ps->next = buckets[j];
+                buckets[j] = ps;
+            }
+        }
+        XtFree((char *) searchLists.buckets);
+        searchLists.buckets = buckets;
+        searchLists.size = size;
+    }
+    ps = XtNew(ParentSearchListsRec);
+    ps->parent = parent;
+    ps->count = 0;
+    ps->lists = NULL;
+    i = SEARCH_LIST_HASH(parent, searchLists.size);
+    ps->next = searchLists.buckets[i];
+    searchLists.buckets[i] = ps;
+    searchLists.count++;
+    return ps;
+}
+
+/*
+ * Copy the cached search list of widget in db into *pSearchList, growing
+ * it if needed.  Returns False if no list is cached.
+ */
+static Boolean
+GetCachedSearchList(Widget widget,
+                    XrmDatabase db,
+                    XrmHashTable **pSearchList,
+                    unsigned int *pSearchListSize,
+                    XrmHashTable *stackSearchList)
+{
+    ParentSearchLists ps;
+    SearchList sl, *prev;
+    XrmClass class = XtClass(widget)->core_class.xrm_class;
+
+    if (!(ps = FindParentSearchLists(widget->core.parent, False)))
+        return False;
+    for (prev = &ps->lists; (sl = *prev); prev = &sl->next) {
+        if (sl->name == widget->core.xrm_name &&
+            sl->class == class && sl->db == db)
+            break;
+    }
+    if (!sl)
+        return False;
+    *prev = sl->next;
+    if (sl->stamp != DatabaseStamp(db)) {
+        XtFree((char *) sl);
+        ps->count--;
+        return False;
+    }
+    sl->next = ps->lists;
+    ps->lists = sl;
+    if (sl->length > *pSearchListSize) {
+        if (*pSearchList != stackSearchList)
+            XtFree((char *) *pSearchList);
+        *pSearchListSize = sl->length;
+        *pSearchList = (XrmHashTable *)
+            __XtMalloc((Cardinal) (sizeof(XrmHashTable) * sl->length));
+    }
+    (void) memcpy(*pSearchList, sl->list, sizeof(XrmHashTable) * sl->length);
+    return True;
+}
+
+static void
+CacheSearchList(Widget widget, XrmDatabase db, XrmHashTable *searchList)
+{
+    ParentSearchLists ps;
+    SearchList sl, *prev;
+    unsigned int length;
+
+    for (length = 1; searchList[length - 1]; length++);
+    ps = FindParentSearchLists(widget->core.parent, True);
+    if (ps->count == MAXPARENTSEARCHLISTS) {
+        for (prev = &ps->lists; (*prev)->next; prev = &(*prev)->next);
+        XtFree((char *) *prev);
+        *prev = NULL;
+        ps->count--;
+    }
+    sl = (SearchList)
+        __XtMalloc((Cardinal) (sizeof(SearchListRec) +
+                               sizeof(XrmHashTable) * (length - 1)));
+    sl->name = widget->core.xrm_name;
+    sl->class = XtClass(widget)->core_class.xrm_class;
+    sl->db = db;
+    sl->stamp = DatabaseStamp(db);
+    sl->length = length;
+    (void) memcpy(sl->list, searchList, sizeof(XrmHashTable) * length);
+    sl->next = ps->lists;
+    ps->lists = sl;
+    ps->count++;
+}
+
 static XtCacheRef *
 GetResources(Widget widget,             /* Widget resources are associated with */
              char *base,                /* Base address of memory to write to */
@@ -480,7 +739,8 @@ GetResources(Widget widget,             /* Widget resources are associated with
              unsigned num_args,         /* number of items in arg list  */
              XtTypedArgList typed_args, /* Typed arg list to override resources */
              Cardinal *pNumTypedArgs,   /* number of items in typed arg list    */
-             Boolean tm_hack)           /* do baseTranslations                  */
+             Boolean tm_hack,           /* do baseTranslations                  */
+             Boolean cache_search_list) /* names and classes are the widget's   */
 {            
 /*
  * assert: *pNumTypedArgs == 0 if num_args > 0
@@ -592,14 +852,22 @@ GetResources(Widget widget,             /* Widget resources are associated with
        do a single-level search on each resource */
 
     db = XtScreenDatabase(XtScreenOfObject(widget));
-    while (!XrmQGetSearchList(db, names, classes,
-                              searchList, (int) searchListSize)) {
-        if (searchList == stackSearchList)
-            searchList = NULL;
-        searchList = (XrmHashTable *) XtRealloc((char *) searchList,
-                                                (Cardinal) (sizeof(XrmHashTable)
-                                                            * (searchListSize *=
-                                                               2)));
+    if (XtIsShell(widget) || widget->core.parent == NULL)
+        cache_search_list = False;
+    if (!cache_search_list ||
+        !GetCachedSearchList(widget, db, &searchList, &searchListSize,
+                             stackSearchList)) {
+        while (!XrmQGetSearchList(db, names, classes,
+                                  searchList, (int) searchListSize)) {
+            if (searchList == stackSearchList)
+                searchList = NULL;
+            searchList = (XrmHashTable *)
+                XtRealloc((char *) searchList,
+                          (Cardinal) (sizeof(XrmHashTable)
+                                      * (searchListSize *= 2)));
+        }
+        if (cache_search_list)
+            CacheSearchList(widget, db, searchList);
     }
 
     if (persistent_resources)
@@ -1008,7 +1276,7 @@ _XtGetResources(register Widget w,
                                   (XrmResourceList *) wc->core_class.resources,
                                   wc->core_class.num_resources, quark_args,
                                   args, num_args, typed_args, num_typed_args,
-                                  XtIsWidget(w));
+                                  XtIsWidget(w), True);
 
         if (w->core.constraints != NULL) {
             ConstraintWidgetClass cwc;
@@ -1020,7 +1288,7 @@ _XtGetResources(register Widget w,
                              (XrmResourceList *) cwc->constraint_class.
                              resources, cwc->constraint_class.num_resources,
                              quark_args, args, num_args, typed_args,
-                             num_typed_args, False);
+                             num_typed_args, False, True);
             XtFree((char *) cache_refs_core);
         }
         FreeCache(quark_cache, quark_args);
@@ -1031,6 +1299,68 @@ _XtGetResources(register Widget w,
     return cache_refs;
 }                               /* _XtGetResources */
 
+static void
+CopyResources(char *base,
+              char *template_base,
+              XrmResourceList *table,
+              Cardinal num_resources,
+              ArgList args,
+              Cardinal num_args)
+{
+    register XrmResourceList rx;
+    Cardinal i, j;
+
+    for (j = 0; j < num_resources; j++) {
+        rx = table[j];
+        (void) memmove(base - rx->xrm_offset - 1,
+                       template_base - rx->xrm_offset - 1,
+                       (size_t) rx->xrm_size);
+    }
+    for (i = 0; i < num_args; i++) {
+        XrmName argName = StringToName(args[i].name);
+
+        for (j = 0; j < num_resources; j++) {
+            rx = table[j];
+            if (argName == rx->xrm_name) {
+                _XtCopyFromArg(args[i].value, base - rx->xrm_offset - 1,
+                               rx->xrm_size);
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Give w the resource values that _XtGetResources fetched for template,
+ * a record of the same class with the same name and parent, and then set
+ * those named in args.  This skips the database and the conversions for
+ * siblings that differ only in resources given as args; the caller must
+ * not use it when args name a resource that steers the resolution of the
+ * others, such as the screen, colormap, depth or translations.
+ */
+void
+_XtCopyResources(Widget w, Widget template, ArgList args, Cardinal num_args)
+{
+    WidgetClass wc = XtClass(w);
+
+    LOCK_PROCESS;
+    CopyResources((char *) w, (char *) template,
+                  (XrmResourceList *) wc->core_class.resources,
+                  wc->core_class.num_resources, args, num_args);
+    if (w->core.constraints != NULL) {
+        ConstraintWidgetClass cwc =
+            (ConstraintWidgetClass) XtClass(w->core.parent);
+
+        CopyResources((char *) w->core.constraints,
+                      (char *) template->core.constraints,
+                      (XrmResourceList *) cwc->constraint_class.resources,
+                      cwc->constraint_class.num_resources, args, num_args);
+    }
+    if (XtIsWidget(w))
+        w->core.tm.current_state = template->core.tm.current_state;
+    UNLOCK_PROCESS;
+}
+
 void
 _XtGetSubresources(Widget w,                    /* Widget "parent" of subobject */
                    XtPointer base,              /* Base address to write to */
@@ -1086,7 +1416,7 @@ _XtGetSubresources(Widget w,                    /* Widget "parent" of subobject
         Resrc =
             GetResources(w, (char *) base, names, classes, table, num_resources,
                          quark_args, args, num_args, typed_args, &ntyped_args,
-                         False);
+                         False, False);
         FreeCache(quark_cache, quark_args);
         XtFree((char *) table);
         XtFree((char *) Resrc);
@@ -1185,7 +1515,7 @@ _XtGetApplicationResources(Widget w,            /* Application shell widget */
 
     Resrc = GetResources(w, (char *) base, names, classes, table, num_resources,
                          quark_args, args, num_args,
-                         typed_args, &ntyped_args, False);
+                         typed_args, &ntyped_args, False, False);
     FreeCache(quark_cache, quark_args);
     XtFree((char *) table);
     XtFree((char *) Resrc);
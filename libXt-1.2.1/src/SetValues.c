@@ -191,6 +191,419 @@ XtSetSubvalues(XtPointer base,                  /* Base address to write values
     XtFree((char *) xrmres);
 }
 
+/*
+ * The second half of XtSetValues: negotiate the geometry in geoReq with
+ * the parent, call the resize procedure, and clear the window when the
+ * set_values chain asked for redisplay.  oldw holds the widget as it was
+ * before the change.
+ */
+static void
+FinishSetValues(Widget w, Widget oldw, XtWidgetGeometry *geoReq,
+                Boolean redisplay)
+{
+    Boolean cleared_rect_obj = False;
+    XtGeometryResult result = XtGeometryYes;
+    XtWidgetGeometry geoReply;
+    WidgetClass wc = XtClass(w);
+    XtAppContext app = XtWidgetToApplicationContext(w);
+    Widget hookobj = XtHooksOfDisplay(XtDisplayOfObject(w));
+
+    if (geoReq->request_mode != 0) {
+        CALLGEOTAT(_XtGeoTrace(w,
+                               "\nXtSetValues sees some geometry changes for \"%s\".\n",
+                               XtName(w)));
+        CALLGEOTAT(_XtGeoTab(1));
+        do {
+            XtGeometryHookDataRec call_data;
+            XtAlmostProc set_values_almost;
+
+            if (XtHasCallbacks(hookobj, XtNgeometryHook) ==
+                XtCallbackHasSome) {
+                call_data.type = XtHpreGeometry;
+                call_data.widget = w;
+                call_data.request = geoReq;
+                XtCallCallbackList(hookobj,
+                                   ((HookObject) hookobj)->hooks.
+                                   geometryhook_callbacks,
+                                   (XtPointer) &call_data);
+                call_data.result = result =
+                    _XtMakeGeometryRequest(w, geoReq, &geoReply,
+                                           &cleared_rect_obj);
+                call_data.type = XtHpostGeometry;
+                call_data.reply = &geoReply;
+                XtCallCallbackList(hookobj,
+                                   ((HookObject) hookobj)->hooks.
+                                   geometryhook_callbacks,
+                                   (XtPointer) &call_data);
+            }
+            else {
+                result = _XtMakeGeometryRequest(w, geoReq, &geoReply,
+                                                &cleared_rect_obj);
+            }
+            if (result == XtGeometryYes || result == XtGeometryDone)
+                break;
+
+            /* An Almost or No reply.  Call widget and let it munge
+               request, reply */
+            LOCK_PROCESS;
+            set_values_almost = wc->core_class.set_values_almost;
+            UNLOCK_PROCESS;
+            if (set_values_almost == NULL) {
+                XtAppWarningMsg(app,
+                                "invalidProcedure", "set_values_almost",
+                                XtCXtToolkitError,
+                                "set_values_almost procedure shouldn't be NULL",
+                                NULL, NULL);
+                break;
+            }
+            if (result == XtGeometryNo)
+                geoReply.request_mode = 0;
+            CALLGEOTAT(_XtGeoTrace(w, "calling SetValuesAlmost.\n"));
+            (*set_values_almost) (oldw, w, geoReq, &geoReply);
+        } while (geoReq->request_mode != 0);
+        /* call resize proc if we changed size and parent
+         * didn't already invoke resize */
+        {
+            XtWidgetProc resize;
+
+            LOCK_PROCESS;
+            resize = wc->core_class.resize;
+            UNLOCK_PROCESS;
+            if ((w->core.width != oldw->core.width ||
+                 w->core.height != oldw->core.height)
+                && result != XtGeometryDone
+                && resize != (XtWidgetProc) NULL) {
+                CALLGEOTAT(_XtGeoTrace(w,
+                                       "XtSetValues calls \"%s\"'s resize proc.\n",
+                                       XtName(w)));
+                (*resize) (w);
+            }
+        }
+        CALLGEOTAT(_XtGeoTab(-1));
+    }
+    /* Redisplay if needed.  No point in clearing if the window is
+     * about to disappear, as the Expose event will just go straight
+     * to the bit bucket. */
+    if (XtIsWidget(w)) {
+        /* widgets can distinguish between redisplay and resize, since
+           the server will cause an expose on resize */
+        if (redisplay && XtIsRealized(w) && !w->core.being_destroyed) {
+            CALLGEOTAT(_XtGeoTrace(w,
+                                   "XtSetValues calls ClearArea on \"%s\".\n",
+                                   XtName(w)));
+            XClearArea(XtDisplay(w), XtWindow(w), 0, 0, 0, 0, TRUE);
+        }
+    }
+    else {                      /*non-window object */
+        if (redisplay && !cleared_rect_obj) {
+            Widget pw = _XtWindowedAncestor(w);
+
+            if (XtIsRealized(pw) && !pw->core.being_destroyed) {
+                RectObj r = (RectObj) w;
+                int bw2 = r->rectangle.border_width << 1;
+
+                CALLGEOTAT(_XtGeoTrace(w,
+                                       "XtSetValues calls ClearArea on \"%s\"'s parent \"%s\".\n",
+                                       XtName(w), XtName(pw)));
+                XClearArea(XtDisplay(pw), XtWindow(pw),
+                           r->rectangle.x, r->rectangle.y,
+                           (unsigned) (r->rectangle.width + bw2),
+                           (unsigned) (r->rectangle.height + bw2), TRUE);
+            }
+        }
+    }
+}                               /* FinishSetValues */
+
+/*
+ * SetValues transactions.  Between XtBeginSetValuesTransaction and the
+ * matching XtCommitSetValuesTransaction, XtSetValues applies the new
+ * resource values and runs the set_values chains as usual, but keeps the
+ * widget's geometry and does not clear its window.  The geometry requests
+ * and redisplays are merged per widget instead, and the outermost commit
+ * negotiates and redisplays each widget once, in order of first change.
+ * Until then XtGetValues returns the old geometry, but XtSetValues and the
+ * set_values procedures it calls see the merged geometry, so the last
+ * value set wins.  A copy of the widget from before its first change is
+ * kept for the set_values_almost procedure.
+ */
+
+typedef struct _PendingSetValuesRec {
+    Widget widget;              /* NULL once the widget is destroyed */
+    Widget old;                 /* copy from before the first change */
+    Cardinal constraint_size;   /* of the constraints copied with it */
+    XtWidgetGeometry request;   /* merged geometry request */
+    Boolean redisplay;
+    int next;                   /* next entry in the bucket, or -1 */
+} PendingSetValuesRec;
+
+static struct {
+    int depth;
+    Boolean committing;
+    PendingSetValuesRec *entries;       /* in order of first change */
+    int count;
+    int size;                   /* a power of two */
+    int *buckets;               /* size heads of the hash chains */
+    unsigned long deferred;
+    unsigned long finished;
+} setValuesTransaction;
+
+#define PENDING_HASH(w) \
+    ((int) (((unsigned long) (w) >> 4) & (unsigned long) (setValuesTransaction.size - 1)))
+
+static void
+ExpandPendingSetValues(void)
+{
+    int i, size = setValuesTransaction.size ? setValuesTransaction.size * 2 : 64;
+
+    setValuesTransaction.entries = (PendingSetValuesRec *)
+        XtRealloc((char *) setValuesTransaction.entries,
+                  (Cardinal) ((size_t) size * sizeof(PendingSetValuesRec)));
+    XtFree((char *) setValuesTransaction.buckets);
+    setValuesTransaction.buckets = (int *)
+        __XtMalloc((Cardinal) ((size_t) size * sizeof(int)));
+    setValuesTransaction.size = size;
+    for (i = 0; i < size; i++)
+        setValuesTransaction.buckets[i] = -1;
+    for (i = 0; i < setValuesTransaction.count; i++) {
+        PendingSetValuesRec *p = setValuesTransaction.entries + i;
+
+        if (p->widget) {
+            int h = PENDING_HASH(p->widget);
+
+            p->next = setValuesTransaction.buckets[h];
+            setValuesTransaction.buckets[h] = i;
+        }
+    }
+}
+
+static PendingSetValuesRec *
+FindPendingSetValues(Widget w)
+{
+    int i;
+
+    if (setValuesTransaction.size == 0)
+        return NULL;
+    for (i = setValuesTransaction.buckets[PENDING_HASH(w)]; i >= 0;
+         i = setValuesTransaction.entries[i].next)
+        if (setValuesTransaction.entries[i].widget == w)
+            return setValuesTransaction.entries + i;
+    return NULL;
+}
+
+static Widget
+CopyOldWidget(Widget oldw, Cardinal widgetSize, Cardinal constraintSize)
+{
+    Widget old = (Widget) __XtMalloc(widgetSize);
+
+    (void) memmove((char *) old, (char *) oldw, (size_t) widgetSize);
+    if (constraintSize) {
+        old->core.constraints = __XtMalloc(constraintSize);
+        (void) memmove((char *) old->core.constraints,
+                       (char *) oldw->core.constraints,
+                       (size_t) constraintSize);
+    }
+    return old;
+}
+
+static void
+FreeOldWidget(Widget old, Cardinal constraintSize)
+{
+    if (constraintSize)
+        XtFree((char *) old->core.constraints);
+    XtFree((char *) old);
+}
+
+/*
+ * Saves the current geometry of w in current and, inside a transaction,
+ * gives w its merged pending geometry for the duration of XtSetValues;
+ * DeferSetValues restores the current geometry.
+ */
+static void
+ApplyPendingSetValues(Widget w, XtWidgetGeometry *current)
+{
+    PendingSetValuesRec *p;
+
+    current->x = w->core.x;
+    current->y = w->core.y;
+    current->width = w->core.width;
+    current->height = w->core.height;
+    current->border_width = w->core.border_width;
+    LOCK_PROCESS;
+    if (setValuesTransaction.depth > 0 && setValuesTransaction.count &&
+        (p = FindPendingSetValues(w)) != NULL) {
+        XtGeometryMask mode = p->request.request_mode;
+
+        if (mode & CWX)
+            w->core.x = p->request.x;
+        if (mode & CWY)
+            w->core.y = p->request.y;
+        if (mode & CWWidth)
+            w->core.width = p->request.width;
+        if (mode & CWHeight)
+            w->core.height = p->request.height;
+        if (mode & CWBorderWidth)
+            w->core.border_width = p->request.border_width;
+    }
+    UNLOCK_PROCESS;
+}
+
+/*
+ * Merges geoReq, made against the merged geometry, into the pending
+ * request of w, dropping the fields that are back at their current value,
+ * and puts the current geometry back into w.  oldw is copied when this is
+ * the first change to w, even one without geometry, so that the copy
+ * predates every change the commit finishes.
+ */
+static void
+DeferSetValues(Widget w, Widget oldw, Cardinal widgetSize,
+               Cardinal constraintSize, XtWidgetGeometry *geoReq,
+               Boolean redisplay, XtWidgetGeometry *current)
+{
+    PendingSetValuesRec *p;
+    XtGeometryMask mode = geoReq->request_mode;
+
+    w->core.x = current->x;
+    w->core.y = current->y;
+    w->core.width = current->width;
+    w->core.height = current->height;
+    w->core.border_width = current->border_width;
+    LOCK_PROCESS;
+    if ((p = FindPendingSetValues(w)) == NULL) {
+        int h;
+
+        if (setValuesTransaction.count == setValuesTransaction.size)
+            ExpandPendingSetValues();
+        p = setValuesTransaction.entries + setValuesTransaction.count;
+        h = PENDING_HASH(w);
+        p->widget = w;
+        p->old = CopyOldWidget(oldw, widgetSize, constraintSize);
+        p->constraint_size = constraintSize;
+        p->request.request_mode = 0;
+        p->request.x = current->x;
+        p->request.y = current->y;
+        p->request.width = current->width;
+        p->request.height = current->height;
+        p->request.border_width = current->border_width;
+        p->redisplay = False;
+        p->next = setValuesTransaction.buckets[h];
+        setValuesTransaction.buckets[h] = setValuesTransaction.count++;
+    }
+    if (mode & CWX)
+        p->request.x = geoReq->x;
+    if (mode & CWY)
+        p->request.y = geoReq->y;
+    if (mode & CWWidth)
+        p->request.width = geoReq->width;
+    if (mode & CWHeight)
+        p->request.height = geoReq->height;
+    if (mode & CWBorderWidth)
+        p->request.border_width = geoReq->border_width;
+    p->request.request_mode |= mode;
+    if (p->request.x == current->x)
+        p->request.request_mode &= ~CWX;
+    if (p->request.y == current->y)
+        p->request.request_mode &= ~CWY;
+    if (p->request.width == current->width)
+        p->request.request_mode &= ~CWWidth;
+    if (p->request.height == current->height)
+        p->request.request_mode &= ~CWHeight;
+    if (p->request.border_width == current->border_width)
+        p->request.request_mode &= ~CWBorderWidth;
+    p->redisplay |= redisplay;
+    if (mode != 0 || redisplay)
+        setValuesTransaction.deferred++;
+    UNLOCK_PROCESS;
+}
+
+void
+XtBeginSetValuesTransaction(void)
+{
+    LOCK_PROCESS;
+    setValuesTransaction.depth++;
+    UNLOCK_PROCESS;
+}
+
+void
+XtCommitSetValuesTransaction(void)
+{
+    int i;
+
+    LOCK_PROCESS;
+    if (setValuesTransaction.depth == 0 || --setValuesTransaction.depth > 0
+        || setValuesTransaction.committing) {
+        UNLOCK_PROCESS;
+        return;
+    }
+    /* Widgets changed by a transaction inside a resize procedure are
+     * appended, and finished by this loop too. */
+    setValuesTransaction.committing = True;
+    for (i = 0; i < setValuesTransaction.count; i++) {
+        PendingSetValuesRec *p = setValuesTransaction.entries + i;
+        Widget w = p->widget;
+        XtWidgetGeometry geoReq;
+        Boolean redisplay;
+        Cardinal constraintSize;
+        Widget oldw;
+        XtAppContext app;
+
+        if (w == NULL)
+            continue;
+        geoReq = p->request;
+        redisplay = p->redisplay;
+        oldw = p->old;
+        constraintSize = p->constraint_size;
+        p->widget = NULL;
+        p->old = NULL;
+        UNLOCK_PROCESS;
+
+        app = XtWidgetToApplicationContext(w);
+        LOCK_APP(app);
+        /* The parent may have moved or resized w since the copy was made. */
+        oldw->core.x = w->core.x;
+        oldw->core.y = w->core.y;
+        oldw->core.width = w->core.width;
+        oldw->core.height = w->core.height;
+        oldw->core.border_width = w->core.border_width;
+        FinishSetValues(w, oldw, &geoReq, redisplay);
+        FreeOldWidget(oldw, constraintSize);
+        UNLOCK_APP(app);
+
+        LOCK_PROCESS;
+        setValuesTransaction.finished++;
+    }
+    setValuesTransaction.count = 0;
+    for (i = 0; i < setValuesTransaction.size; i++)
+        setValuesTransaction.buckets[i] = -1;
+    setValuesTransaction.committing = False;
+    UNLOCK_PROCESS;
+}
+
+/* Called from ObjectDestroy. */
+void
+_XtFlushSetValues(Widget w)
+{
+    PendingSetValuesRec *p;
+
+    LOCK_PROCESS;
+    if (setValuesTransaction.count && (p = FindPendingSetValues(w)) != NULL) {
+        p->widget = NULL;
+        FreeOldWidget(p->old, p->constraint_size);
+        p->old = NULL;
+    }
+    UNLOCK_PROCESS;
+}
+
+void
+_XtGetSetValuesStatistics(unsigned long *deferred, unsigned long *finished,
+                          unsigned long *pending)
+{
+    LOCK_PROCESS;
+    *deferred = setValuesTransaction.deferred;
+    *finished = setValuesTransaction.finished;
+    *pending = (unsigned long) setValuesTransaction.count;
+    UNLOCK_PROCESS;
+}
+
 void
 XtSetValues(register Widget w, ArgList args, Cardinal num_args)
 {
@@ -200,9 +613,8 @@ XtSetValues(register Widget w, ArgList args, Cardinal num_args)
     double oldwCache[100], reqwCache[100];
     double oldcCache[20], reqcCache[20];
     Cardinal widgetSize, constraintSize;
-    Boolean redisplay, cleared_rect_obj = False;
-    XtGeometryResult result;
-    XtWidgetGeometry geoReq, geoReply;
+    Boolean redisplay;
+    XtWidgetGeometry geoReq, current;
     WidgetClass wc;
     ConstraintWidgetClass cwc = NULL;
     Boolean hasConstraints;
@@ -223,6 +635,10 @@ XtSetValues(register Widget w, ArgList args, Cardinal num_args)
     LOCK_PROCESS;
     widgetSize = wc->core_class.widget_size;
     UNLOCK_PROCESS;
+    if (XtIsRectObj(w))
+        ApplyPendingSetValues(w, &current);
+    else
+        memset(&current, 0, sizeof(current));
     oldw = (Widget) XtStackAlloc(widgetSize, oldwCache);
     reqw = (Widget) XtStackAlloc(widgetSize, reqwCache);
     (void) memmove((char *) oldw, (char *) w, (size_t) widgetSize);
@@ -355,109 +771,12 @@ XtSetValues(register Widget w, ArgList args, Cardinal num_args)
                     }
                 }
             }
-            CALLGEOTAT(_XtGeoTrace(w,
-                                   "\nXtSetValues sees some geometry changes for \"%s\".\n",
-                                   XtName(w)));
-            CALLGEOTAT(_XtGeoTab(1));
-            do {
-                XtGeometryHookDataRec call_data;
-                XtAlmostProc set_values_almost;
-
-                if (XtHasCallbacks(hookobj, XtNgeometryHook) ==
-                    XtCallbackHasSome) {
-                    call_data.type = XtHpreGeometry;
-                    call_data.widget = w;
-                    call_data.request = &geoReq;
-                    XtCallCallbackList(hookobj,
-                                       ((HookObject) hookobj)->hooks.
-                                       geometryhook_callbacks,
-                                       (XtPointer) &call_data);
-                    call_data.result = result =
-                        _XtMakeGeometryRequest(w, &geoReq, &geoReply,
-                                               &cleared_rect_obj);
-                    call_data.type = XtHpostGeometry;
-                    call_data.reply = &geoReply;
-                    XtCallCallbackList(hookobj,
-                                       ((HookObject) hookobj)->hooks.
-                                       geometryhook_callbacks,
-                                       (XtPointer) &call_data);
-                }
-                else {
-                    result = _XtMakeGeometryRequest(w, &geoReq, &geoReply,
-                                                    &cleared_rect_obj);
-                }
-                if (result == XtGeometryYes || result == XtGeometryDone)
-                    break;
-
-                /* An Almost or No reply.  Call widget and let it munge
-                   request, reply */
-                LOCK_PROCESS;
-                set_values_almost = wc->core_class.set_values_almost;
-                UNLOCK_PROCESS;
-                if (set_values_almost == NULL) {
-                    XtAppWarningMsg(app,
-                                    "invalidProcedure", "set_values_almost",
-                                    XtCXtToolkitError,
-                                    "set_values_almost procedure shouldn't be NULL",
-                                    NULL, NULL);
-                    break;
-                }
-                if (result == XtGeometryNo)
-                    geoReply.request_mode = 0;
-                CALLGEOTAT(_XtGeoTrace(w, "calling SetValuesAlmost.\n"));
-                (*set_values_almost) (oldw, w, &geoReq, &geoReply);
-            } while (geoReq.request_mode != 0);
-            /* call resize proc if we changed size and parent
-             * didn't already invoke resize */
-            {
-                XtWidgetProc resize;
-
-                LOCK_PROCESS;
-                resize = wc->core_class.resize;
-                UNLOCK_PROCESS;
-                if ((w->core.width != oldw->core.width ||
-                     w->core.height != oldw->core.height)
-                    && result != XtGeometryDone
-                    && resize != (XtWidgetProc) NULL) {
-                    CALLGEOTAT(_XtGeoTrace(w,
-                                           "XtSetValues calls \"%s\"'s resize proc.\n",
-                                           XtName(w)));
-                    (*resize) (w);
-                }
-            }
-            CALLGEOTAT(_XtGeoTab(-1));
-        }
-        /* Redisplay if needed.  No point in clearing if the window is
-         * about to disappear, as the Expose event will just go straight
-         * to the bit bucket. */
-        if (XtIsWidget(w)) {
-            /* widgets can distinguish between redisplay and resize, since
-               the server will cause an expose on resize */
-            if (redisplay && XtIsRealized(w) && !w->core.being_destroyed) {
-                CALLGEOTAT(_XtGeoTrace(w,
-                                       "XtSetValues calls ClearArea on \"%s\".\n",
-                                       XtName(w)));
-                XClearArea(XtDisplay(w), XtWindow(w), 0, 0, 0, 0, TRUE);
-            }
-        }
-        else {                  /*non-window object */
-            if (redisplay && !cleared_rect_obj) {
-                Widget pw = _XtWindowedAncestor(w);
-
-                if (XtIsRealized(pw) && !pw->core.being_destroyed) {
-                    RectObj r = (RectObj) w;
-                    int bw2 = r->rectangle.border_width << 1;
-
-                    CALLGEOTAT(_XtGeoTrace(w,
-                                           "XtSetValues calls ClearArea on \"%s\"'s parent \"%s\".\n",
-                                           XtName(w), XtName(pw)));
-                    XClearArea(XtDisplay(pw), XtWindow(pw),
-                               r->rectangle.x, r->rectangle.y,
-                               (unsigned) (r->rectangle.width + bw2),
-                               (unsigned) (r->rectangle.height + bw2), TRUE);
-                }
-            }
         }
+        if (setValuesTransaction.depth > 0)
+            DeferSetValues(w, oldw, widgetSize, constraintSize, &geoReq,
+                           redisplay, &current);
+        else
+            FinishSetValues(w, oldw, &geoReq, redisplay);
     }
 
     /* Free dynamic storage */
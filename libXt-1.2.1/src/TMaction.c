@@ -284,20 +284,38 @@ typedef struct _TMBindCacheStatusRec {
 } TMBindCacheStatusRec, *TMBindCacheStatus;
 
 typedef struct _TMBindCacheRec {
-    struct _TMBindCacheRec *next;
+    struct _TMBindCacheRec *next;       /* must remain first */
     TMBindCacheStatusRec status;
     TMStateTree stateTree;
-#ifdef TRACE_TM
     WidgetClass widgetClass;
-#endif                          /* TRACE_TM */
     XtActionProc procs[1];      /* variable length */
 } TMBindCacheRec, *TMBindCache;
 
 typedef struct _TMClassCacheRec {
     CompiledActionTable actions;
-    TMBindCacheRec *bindCache;
 } TMClassCacheRec, *TMClassCache;
 
+/*
+ * The bind cache is a hash table keyed by the class of the widget the
+ * actions are bound for (the accelerator source for accelerators) and
+ * the state tree.  Each bucket chains the bindings of all keys hashing
+ * to it.
+ */
+static struct {
+    TMBindCache *buckets;
+    Cardinal size;              /* a power of two */
+    Cardinal count;
+    unsigned long hits;
+    unsigned long misses;
+} bindCache;
+
+#define BIND_CACHE_HASH(widgetClass, stateTree, size) \
+    ((Cardinal) ((((unsigned long) (widgetClass) >> 4) * 31 + \
+                  ((unsigned long) (stateTree) >> 4)) & ((size) - 1)))
+
+void _XtGetBindCacheStatistics(unsigned long *, unsigned long *,
+                               unsigned long *);
+
 #define IsPureClassBind(bc) \
   (bc->status.boundInClass && \
    !(bc->status.boundInHierarchy || \
@@ -384,18 +402,23 @@ TryBindCache(Widget widget, TMStateTree stateTree)
         wc->core_class.actions = (XtActionList)
             _XtInitializeActionData(NULL, 0, True);
     }
-    else {
-        TMBindCache bindCache = (TMBindCache) (classCache->bindCache);
-
-        for (; bindCache; bindCache = bindCache->next) {
-            if (IsPureClassBind(bindCache) &&
-                (stateTree == bindCache->stateTree)) {
-                bindCache->status.refCount++;
+    else if (bindCache.size) {
+        WidgetClass wc = XtClass(widget);
+        TMBindCache bc;
+
+        for (bc = bindCache.buckets[BIND_CACHE_HASH(wc, stateTree,
+                                                    bindCache.size)];
+             bc; bc = bc->next) {
+            if (IsPureClassBind(bc) &&
+                (stateTree == bc->stateTree) && (wc == bc->widgetClass)) {
+                bc->status.refCount++;
+                bindCache.hits++;
                 UNLOCK_PROCESS;
-                return &bindCache->procs[0];
+                return &bc->procs[0];
             }
         }
     }
+    bindCache.misses++;
     UNLOCK_PROCESS;
     return NULL;
 }
@@ -414,53 +437,76 @@ _XtInitializeActionData(register struct _XtActionsRec *actions,
     classCache = XtNew(TMClassCacheRec);
     classCache->actions =
         CompileActionTable(actions, count, (Boolean) inPlace, True);
-    classCache->bindCache = NULL;
     return (XtPointer) classCache;
 }
 
 #define TM_BIND_CACHE_REALLOC   2
 
+static void
+ExpandBindCache(void)
+{
+    TMBindCache *buckets, bc, next;
+    Cardinal size, i, j;
+
+    size = bindCache.size ? bindCache.size << 1 : 64;
+    buckets = (TMBindCache *) __XtCalloc(size, (Cardinal) sizeof(TMBindCache));
+    for (i = 0; i < bindCache.size; i++) {
+        for (bc = bindCache.buckets[i]; bc; bc = next) {
+            next = bc->next;
+            j = BIND_CACHE_HASH(bc->widgetClass, bc->stateTree, size);
+            bc->next = buckets[j];
+            buckets[j] = bc;
+        }
+    }
+    XtFree((char *) bindCache.buckets);
+    bindCache.buckets = buckets;
+    bindCache.size = size;
+}
+
 static XtActionProc *
 EnterBindCache(Widget w,
                TMSimpleStateTree stateTree,
                XtActionProc *procs,
                TMBindCacheStatus bindStatus)
 {
-    TMClassCache classCache;
+    WidgetClass wc = XtClass(w);
     TMBindCache *bindCachePtr;
     TMShortCard procsSize;
-    TMBindCache bindCache;
+    TMBindCache bc;
 
     LOCK_PROCESS;
-    classCache = GetClassCache(w);
-    bindCachePtr = &classCache->bindCache;
+    if (bindCache.count >= bindCache.size)
+        ExpandBindCache();
+    bindCachePtr = &bindCache.buckets[BIND_CACHE_HASH(wc, stateTree,
+                                                      bindCache.size)];
     procsSize = (TMShortCard) (stateTree->numQuarks * sizeof(XtActionProc));
 
-    for (bindCache = *bindCachePtr;
-         (*bindCachePtr);
-         bindCachePtr = &(*bindCachePtr)->next, bindCache = *bindCachePtr) {
-        TMBindCacheStatus cacheStatus = &bindCache->status;
+    for (bc = *bindCachePtr; bc; bc = bc->next) {
+        TMBindCacheStatus cacheStatus = &bc->status;
 
         if ((bindStatus->boundInClass == cacheStatus->boundInClass) &&
             (bindStatus->boundInHierarchy == cacheStatus->boundInHierarchy) &&
             (bindStatus->boundInContext == cacheStatus->boundInContext) &&
-            (bindCache->stateTree == (TMStateTree) stateTree) &&
-            !XtMemcmp(&bindCache->procs[0], procs, procsSize)) {
-            bindCache->status.refCount++;
+            (bc->stateTree == (TMStateTree) stateTree) &&
+            (bc->widgetClass == wc) &&
+            !XtMemcmp(&bc->procs[0], procs, procsSize)) {
+            bc->status.refCount++;
             break;
         }
     }
-    if (*bindCachePtr == NULL) {
-        *bindCachePtr = bindCache = (TMBindCache)
+    if (bc == NULL) {
+        bc = (TMBindCache)
             __XtMalloc((Cardinal) (sizeof(TMBindCacheRec) +
                                    (size_t) (procsSize -
                                              sizeof(XtActionProc))));
-        bindCache->next = NULL;
-        bindCache->status = *bindStatus;
-        bindCache->status.refCount = 1;
-        bindCache->stateTree = (TMStateTree) stateTree;
+        bc->next = *bindCachePtr;
+        *bindCachePtr = bc;
+        bindCache.count++;
+        bc->status = *bindStatus;
+        bc->status.refCount = 1;
+        bc->stateTree = (TMStateTree) stateTree;
+        bc->widgetClass = wc;
 #ifdef TRACE_TM
-        bindCache->widgetClass = XtClass(w);
         if (_XtGlobalTM.numBindCache == _XtGlobalTM.bindCacheTblSize) {
             _XtGlobalTM.bindCacheTblSize =
                 (TMShortCard) (_XtGlobalTM.bindCacheTblSize + 16);
@@ -469,58 +515,72 @@ EnterBindCache(Widget w,
                           (Cardinal) ((_XtGlobalTM.bindCacheTblSize) *
                                       sizeof(TMBindCache)));
         }
-        _XtGlobalTM.bindCacheTbl[_XtGlobalTM.numBindCache++] = bindCache;
+        _XtGlobalTM.bindCacheTbl[_XtGlobalTM.numBindCache++] = bc;
 #endif                          /* TRACE_TM */
-        XtMemmove((XtPointer) &bindCache->procs[0],
-                  (XtPointer) procs, procsSize);
+        XtMemmove((XtPointer) &bc->procs[0], (XtPointer) procs, procsSize);
     }
     UNLOCK_PROCESS;
-    return &bindCache->procs[0];
+    return &bc->procs[0];
 }
 
 static void
 RemoveFromBindCache(Widget w, XtActionProc *procs)
 {
-    TMClassCache classCache;
     TMBindCache *bindCachePtr;
-    TMBindCache bindCache;
+    TMBindCache bc;
     XtAppContext app = XtWidgetToApplicationContext(w);
 
+    if (procs == NULL)
+        return;
     LOCK_PROCESS;
-    classCache = GetClassCache(w);
-    bindCachePtr = (TMBindCache *) &classCache->bindCache;
-
-    for (bindCache = *bindCachePtr;
-         *bindCachePtr;
-         bindCachePtr = &(*bindCachePtr)->next, bindCache = *bindCachePtr) {
-        if (&bindCache->procs[0] == procs) {
-            if (--bindCache->status.refCount == 0) {
+    /* procs is the tail of its bind cache record */
+    bc = (TMBindCache) ((char *) procs - XtOffsetOf(TMBindCacheRec, procs));
+    if (--bc->status.refCount == 0) {
 #ifdef TRACE_TM
-                TMShortCard j;
-                Boolean found = False;
-                TMBindCache *tbl = _XtGlobalTM.bindCacheTbl;
-
-                for (j = 0; j < _XtGlobalTM.numBindCache; j++) {
-                    if (found)
-                        tbl[j - 1] = tbl[j];
-                    if (tbl[j] == bindCache)
-                        found = True;
-                }
-                if (!found)
-                    XtWarning("where's the action ??? ");
-                else
-                    _XtGlobalTM.numBindCache--;
-#endif                          /* TRACE_TM */
-                *bindCachePtr = bindCache->next;
-                bindCache->next = app->free_bindings;
-                app->free_bindings = bindCache;
-            }
-            break;
+        TMShortCard j;
+        Boolean found = False;
+        TMBindCache *tbl = _XtGlobalTM.bindCacheTbl;
+
+        for (j = 0; j < _XtGlobalTM.numBindCache; j++) {
+            if (found)
+                tbl[j - 1] = tbl[j];
+            if (tbl[j] == bc)
+                found = True;
         }
+        if (!found)
+            XtWarning("where's the action ??? ");
+        else
+            _XtGlobalTM.numBindCache--;
+#endif                          /* TRACE_TM */
+        bindCachePtr = &bindCache.buckets[BIND_CACHE_HASH(bc->widgetClass,
+                                                          bc->stateTree,
+                                                          bindCache.size)];
+        while (*bindCachePtr != bc)
+            bindCachePtr = &(*bindCachePtr)->next;
+        *bindCachePtr = bc->next;
+        bindCache.count--;
+        bc->next = app->free_bindings;
+        app->free_bindings = bc;
     }
     UNLOCK_PROCESS;
 }
 
+/*
+ * Returns the number of bind cache lookups that found a binding, the
+ * number that had to bind the actions, and the number of bindings held.
+ */
+void
+_XtGetBindCacheStatistics(unsigned long *hits,
+                          unsigned long *misses,
+                          unsigned long *entries)
+{
+    LOCK_PROCESS;
+    *hits = bindCache.hits;
+    *misses = bindCache.misses;
+    *entries = bindCache.count;
+    UNLOCK_PROCESS;
+}
+
 static void
 RemoveAccelerators(Widget widget, XtPointer closure, XtPointer data _X_UNUSED)
 {
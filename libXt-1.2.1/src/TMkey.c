@@ -86,83 +86,176 @@ in this Software without prior written authorization from The Open Group.
 #define FLUSHKEYCACHE(ctx) \
         memset((void *)&ctx->keycache, 0, sizeof(TMKeyCache))
 
+extern unsigned long _XtMatchTableGeneration;   /* from TMstate.c */
+
 /*
- * The following array reorders the modifier bits so that the most common ones
- * (used by a translator) are in the top-most bits with respect to the size of
- * the keycache.  The array currently just reverses the bits as a good guess.
- * This might be more trouble than it is worth, but it seems to help.
+ * Keycode tables.  XtTranslateKey only looks at the Shift and Lock
+ * modifiers and at the modifiers bound to Mode_switch and Num_Lock, so
+ * whenever the keysym tables of a display are built, the translation of
+ * every keycode under every combination of those modifiers is computed
+ * too, and translating a keycode becomes a table lookup.  The tables are
+ * kept on a list, with the last one found cached in front of it, so that
+ * with one display the lookup is a compare and an indexed load.  The
+ * table is only used while XtTranslateKey is the display's key
+ * translator.  With XKB, keys are translated through the per-key types
+ * of the XKB keymap, which may look at any modifier and the group, so
+ * no table is built.
  */
 
-#define FM(i) i >> (8 - TMKEYCACHELOG2)
-
-/* *INDENT-OFF* */
-static const unsigned char modmix[256] = {
-FM(0x0f), FM(0x8f), FM(0x4f), FM(0xcf), FM(0x2f), FM(0xaf), FM(0x6f), FM(0xef),
-FM(0x1f), FM(0x9f), FM(0x5f), FM(0xdf), FM(0x3f), FM(0xbf), FM(0x7f), FM(0xff),
-FM(0x07), FM(0x87), FM(0x47), FM(0xc7), FM(0x27), FM(0xa7), FM(0x67), FM(0xe7),
-FM(0x17), FM(0x97), FM(0x57), FM(0xd7), FM(0x37), FM(0xb7), FM(0x77), FM(0xf7),
-FM(0x0b), FM(0x8b), FM(0x4b), FM(0xcb), FM(0x2b), FM(0xab), FM(0x6b), FM(0xeb),
-FM(0x1b), FM(0x9b), FM(0x5b), FM(0xdb), FM(0x3b), FM(0xbb), FM(0x7b), FM(0xfb),
-FM(0x03), FM(0x83), FM(0x43), FM(0xc3), FM(0x23), FM(0xa3), FM(0x63), FM(0xe3),
-FM(0x13), FM(0x93), FM(0x53), FM(0xd3), FM(0x33), FM(0xb3), FM(0x73), FM(0xf3),
-FM(0x0d), FM(0x8d), FM(0x4d), FM(0xcd), FM(0x2d), FM(0xad), FM(0x6d), FM(0xed),
-FM(0x1d), FM(0x9d), FM(0x5d), FM(0xdd), FM(0x3d), FM(0xbd), FM(0x7d), FM(0xfd),
-FM(0x05), FM(0x85), FM(0x45), FM(0xc5), FM(0x25), FM(0xa5), FM(0x65), FM(0xe5),
-FM(0x15), FM(0x95), FM(0x55), FM(0xd5), FM(0x35), FM(0xb5), FM(0x75), FM(0xf5),
-FM(0x09), FM(0x89), FM(0x49), FM(0xc9), FM(0x29), FM(0xa9), FM(0x69), FM(0xe9),
-FM(0x19), FM(0x99), FM(0x59), FM(0xd9), FM(0x39), FM(0xb9), FM(0x79), FM(0xf9),
-FM(0x01), FM(0x81), FM(0x41), FM(0xc1), FM(0x21), FM(0xa1), FM(0x61), FM(0xe1),
-FM(0x11), FM(0x91), FM(0x51), FM(0xd1), FM(0x31), FM(0xb1), FM(0x71), FM(0xf1),
-FM(0x00), FM(0x8e), FM(0x4e), FM(0xce), FM(0x2e), FM(0xae), FM(0x6e), FM(0xee),
-FM(0x1e), FM(0x9e), FM(0x5e), FM(0xde), FM(0x3e), FM(0xbe), FM(0x7e), FM(0xfe),
-FM(0x08), FM(0x88), FM(0x48), FM(0xc8), FM(0x28), FM(0xa8), FM(0x68), FM(0xe8),
-FM(0x18), FM(0x98), FM(0x58), FM(0xd8), FM(0x38), FM(0xb8), FM(0x78), FM(0xf8),
-FM(0x04), FM(0x84), FM(0x44), FM(0xc4), FM(0x24), FM(0xa4), FM(0x64), FM(0xe4),
-FM(0x14), FM(0x94), FM(0x54), FM(0xd4), FM(0x34), FM(0xb4), FM(0x74), FM(0xf4),
-FM(0x0c), FM(0x8c), FM(0x4c), FM(0xcc), FM(0x2c), FM(0xac), FM(0x6c), FM(0xec),
-FM(0x1c), FM(0x9c), FM(0x5c), FM(0xdc), FM(0x3c), FM(0xbc), FM(0x7c), FM(0xfc),
-FM(0x02), FM(0x82), FM(0x42), FM(0xc2), FM(0x22), FM(0xa2), FM(0x62), FM(0xe2),
-FM(0x12), FM(0x92), FM(0x52), FM(0xd2), FM(0x32), FM(0xb2), FM(0x72), FM(0xf2),
-FM(0x0a), FM(0x8a), FM(0x4a), FM(0xca), FM(0x2a), FM(0xaa), FM(0x6a), FM(0xea),
-FM(0x1a), FM(0x9a), FM(0x5a), FM(0xda), FM(0x3a), FM(0xba), FM(0x7a), FM(0xfa),
-FM(0x06), FM(0x86), FM(0x46), FM(0xc6), FM(0x26), FM(0xa6), FM(0x66), FM(0xe6),
-FM(0x16), FM(0x96), FM(0x56), FM(0xd6), FM(0x36), FM(0xb6), FM(0x76), FM(0xf6),
-FM(0x0e), FM(0x8e), FM(0x4e), FM(0xce), FM(0x2e), FM(0xae), FM(0x6e), FM(0xee),
-FM(0x1e), FM(0x9e), FM(0x5e), FM(0xde), FM(0x3e), FM(0xbe), FM(0x7e), FM(0xfe)
-};
-/* *INDENT-ON* */
-#undef FM
+typedef struct _KeycodeEntry {
+    KeySym keysym;
+    Modifiers modifiers;
+} KeycodeEntry;
+
+typedef struct _KeycodeTableRec {
+    struct _KeycodeTableRec *next;
+    XtPerDisplay pd;
+    int minKeycode;
+    int maxKeycode;
+    Cardinal shift;                     /* log2 of the states per keycode */
+    unsigned char stateIndex[256];      /* modifier state to state number */
+    KeycodeEntry *entries;
+} KeycodeTableRec, *KeycodeTable;
+
+static KeycodeTable keycodeTables;
+static KeycodeTable lastKeycodeTable;
+
+void _XtBuildKeycodeTable(Display *, XtPerDisplay);
+void _XtFreeKeycodeTable(XtPerDisplay);
+
+static KeycodeTable
+FindKeycodeTable(XtPerDisplay pd)
+{
+    KeycodeTable table = lastKeycodeTable;
+
+    if (table != NULL && table->pd == pd)
+        return table;
+    for (table = keycodeTables; table; table = table->next)
+        if (table->pd == pd)
+            break;
+    if (table != NULL)
+        lastKeycodeTable = table;
+    return table;
+}
+
+void
+_XtBuildKeycodeTable(Display *dpy _X_UNUSED, XtPerDisplay pd _X_UNUSED)
+{
+#ifndef XKB
+    KeycodeTable table;
+    Modifiers mask, bits[8];
+    Cardinal numBits = 0, numStates, state, i, j;
+    KeycodeEntry *entry;
+    int keycode;
+
+    LOCK_PROCESS;
+    table = FindKeycodeTable(pd);
+    if (table == NULL) {
+        table = XtNew(KeycodeTableRec);
+        table->pd = pd;
+        table->entries = NULL;
+        table->next = keycodeTables;
+        keycodeTables = table;
+    }
+    XtFree((char *) table->entries);
+
+    mask = (ShiftMask | LockMask | pd->mode_switch | pd->num_lock) & 0xff;
+    for (i = 0; i < 8; i++)
+        if (mask & (1U << i))
+            bits[numBits++] = (Modifiers) (1U << i);
+    for (i = 0; i < 256; i++) {
+        table->stateIndex[i] = 0;
+        for (j = 0; j < numBits; j++)
+            if (i & bits[j])
+                table->stateIndex[i] |= (unsigned char) (1U << j);
+    }
+    numStates = 1U << numBits;
+    table->shift = numBits;
+    table->minKeycode = pd->min_keycode;
+    table->maxKeycode = pd->max_keycode;
+    table->entries = (KeycodeEntry *)
+        __XtMalloc((Cardinal) ((size_t) (pd->max_keycode - pd->min_keycode + 1)
+                               * numStates * sizeof(KeycodeEntry)));
+
+    entry = table->entries;
+    for (keycode = pd->min_keycode; keycode <= pd->max_keycode; keycode++) {
+        for (state = 0; state < numStates; state++, entry++) {
+            Modifiers modifiers = 0;
+
+            for (j = 0; j < numBits; j++)
+                if (state & (1U << j))
+                    modifiers |= bits[j];
+            XtTranslateKey(dpy, (KeyCode) keycode, modifiers,
+                           &entry->modifiers, &entry->keysym);
+        }
+    }
+    UNLOCK_PROCESS;
+#endif
+}
+
+void
+_XtFreeKeycodeTable(XtPerDisplay pd)
+{
+    KeycodeTable *tablePtr, table;
+
+    LOCK_PROCESS;
+    for (tablePtr = &keycodeTables; (table = *tablePtr);
+         tablePtr = &table->next) {
+        if (table->pd == pd) {
+            *tablePtr = table->next;
+            if (lastKeycodeTable == table)
+                lastKeycodeTable = NULL;
+            XtFree((char *) table->entries);
+            XtFree((char *) table);
+            break;
+        }
+    }
+    UNLOCK_PROCESS;
+}
+
+static void
+TranslateKeycode(Display *dpy,
+                 XtPerDisplay pd,
+                 KeyCode keycode,
+                 Modifiers modifiers,
+                 Modifiers *modifiers_return,
+                 KeySym *keysym_return)
+{
+    KeycodeTable table;
+
+    if (pd->defaultKeycodeTranslator == XtTranslateKey &&
+        (table = FindKeycodeTable(pd)) != NULL &&
+        (int) keycode >= table->minKeycode &&
+        (int) keycode <= table->maxKeycode) {
+        KeycodeEntry *entry =
+            &table->entries[((Cardinal) (keycode - table->minKeycode)
+                             << table->shift) +
+                            table->stateIndex[modifiers & 0xff]];
+
+        *modifiers_return = entry->modifiers;
+        *keysym_return = entry->keysym;
+        return;
+    }
+    (*pd->defaultKeycodeTranslator) (dpy, keycode, modifiers, modifiers_return,
+                                     keysym_return);
+}
 
 #define MOD_RETURN(ctx, key) (ctx)->keycache.modifiers_return[key]
 
 #define TRANSLATE(ctx,pd,dpy,key,mod,mod_ret,sym_ret) \
 { \
-    int _i_ = (((key) - (TMLongCard) (pd)->min_keycode + modmix[(mod) & 0xff]) & \
-               (TMKEYCACHESIZE-1)); \
     if ((key) == 0) { /* Xlib XIM composed input */ \
         mod_ret = 0; \
         sym_ret = 0; \
-    } else if (   /* not Xlib XIM composed input */ \
-        (ctx)->keycache.keycode[_i_] == (key) && \
-        (ctx)->keycache.modifiers[_i_] == (mod)) { \
-        mod_ret = MOD_RETURN(ctx, key); \
-        sym_ret = (ctx)->keycache.keysym[_i_]; \
     } else { \
-        XtTranslateKeycode(dpy, (KeyCode) key, mod, &mod_ret, &sym_ret); \
-        (ctx)->keycache.keycode[_i_] = (KeyCode) (key); \
-        (ctx)->keycache.modifiers[_i_] = (unsigned char)(mod); \
-        (ctx)->keycache.keysym[_i_] = sym_ret; \
+        _InitializeKeysymTables(dpy, pd); \
+        TranslateKeycode(dpy, pd, (KeyCode) key, mod, &mod_ret, &sym_ret); \
         MOD_RETURN(ctx, key) = (unsigned char)mod_ret; \
     } \
 }
 
 #define UPDATE_CACHE(ctx, pd, key, mod, mod_ret, sym_ret) \
 { \
-    int _i_ = (((key) - (TMLongCard) (pd)->min_keycode + modmix[(mod) & 0xff]) & \
-               (TMKEYCACHESIZE-1)); \
-    (ctx)->keycache.keycode[_i_] = (KeyCode) (key); \
-    (ctx)->keycache.modifiers[_i_] = (unsigned char)(mod); \
-    (ctx)->keycache.keysym[_i_] = sym_ret; \
     MOD_RETURN(ctx, key) = (unsigned char)(mod_ret); \
 }
 
@@ -526,6 +619,7 @@ _XtBuildKeysymTables(Display *dpy, register XtPerDisplay pd)
         }
     }
     XFreeModifiermap(modKeymap);
+    _XtBuildKeycodeTable(dpy, pd);
 }
 
 void
@@ -542,8 +636,8 @@ XtTranslateKeycode(Display *dpy,
     LOCK_APP(app);
     pd = _XtGetPerDisplay(dpy);
     _InitializeKeysymTables(dpy, pd);
-    (*pd->defaultKeycodeTranslator) (dpy, keycode, modifiers, modifiers_return,
-                                     keysym_return);
+    TranslateKeycode(dpy, pd, (KeyCode) keycode, modifiers, modifiers_return,
+                     keysym_return);
     UNLOCK_APP(app);
 }
 
@@ -630,6 +724,7 @@ XtSetKeyTranslator(Display *dpy, XtKeyProc translator)
 
     pd->defaultKeycodeTranslator = translator;
     FLUSHKEYCACHE(pd->tm_context);
+    _XtMatchTableGeneration++;
     /* XXX should now redo grabs */
     UNLOCK_APP(app);
 }
@@ -666,6 +761,9 @@ XtRegisterCaseConverter(Display *dpy,
             prev = ptr;
     }
     FLUSHKEYCACHE(pd->tm_context);
+    _XtMatchTableGeneration++;
+    if (pd->keysyms)
+        _XtBuildKeycodeTable(dpy, pd);
     /* XXX should now redo grabs */
     UNLOCK_APP(app);
 }
@@ -1957,10 +1957,10 @@ CheckForPoundSign(String str,
 }
 
 static XtTranslations
-ParseTranslationTable(String source,
-                      Boolean isAccelerator,
-                      _XtTranslateOp defaultOp,
-                      Boolean *error)
+ParseTranslationTableSource(String source,
+                            Boolean isAccelerator,
+                            _XtTranslateOp defaultOp,
+                            Boolean *error)
 {
     XtTranslations xlations;
     TMStateTree stateTrees[8];
@@ -2017,6 +2017,127 @@ ParseTranslationTable(String source,
     return xlations;
 }
 
+/*
+ * Parse cache.  Widgets created in bulk usually share their translation
+ * source strings, so the tables parsed from them are kept in a process
+ * wide cache and handed out again for an identical source.  Parsed
+ * tables are never changed once built, so sharing them is safe.  Unless
+ * the conversions are reference counted, Xt never frees a translation
+ * table, so the cache needs no references either; with reference counted
+ * conversions _XtFreeTranslations may free a table, and the conversion
+ * cache already shares tables by source, so the parse cache is left out.
+ * The cache is emptied when the keyboard mapping changes, so that tables
+ * parsed afterwards are built from scratch.  Sources that fail to parse
+ * are not cached, so that their warnings are repeated.
+ */
+
+#if defined(CACHE_TRANSLATIONS) && defined(REFCNT_TRANSLATIONS)
+
+static XtTranslations
+ParseTranslationTable(String source,
+                      Boolean isAccelerator,
+                      _XtTranslateOp defaultOp,
+                      Boolean *error)
+{
+    return ParseTranslationTableSource(source, isAccelerator, defaultOp,
+                                       error);
+}
+
+#else
+
+typedef struct _TMParseCacheRec {
+    struct _TMParseCacheRec *next;
+    String source;
+    Boolean isAccelerator;
+    _XtTranslateOp defaultOp;
+    XtTranslations xlations;
+} TMParseCacheRec, *TMParseCache;
+
+#define PARSE_CACHE_SIZE 256
+
+extern unsigned long _XtMatchTableGeneration;   /* from TMstate.c */
+
+static TMParseCache parseCache[PARSE_CACHE_SIZE];
+static unsigned long parseCacheGeneration;
+
+static Cardinal
+HashSource(String source, Boolean isAccelerator, _XtTranslateOp defaultOp)
+{
+    unsigned long hash = (unsigned long) isAccelerator * 2 + defaultOp;
+
+    while (*source)
+        hash = (hash << 5) + hash + (unsigned char) *source++;
+    return (Cardinal) (hash % PARSE_CACHE_SIZE);
+}
+
+static void
+FlushParseCache(void)
+{
+    Cardinal i;
+
+    for (i = 0; i < PARSE_CACHE_SIZE; i++) {
+        TMParseCache entry;
+
+        while ((entry = parseCache[i])) {
+            parseCache[i] = entry->next;
+            XtFree((char *) entry);
+        }
+    }
+    parseCacheGeneration = _XtMatchTableGeneration;
+}
+
+static XtTranslations
+ParseTranslationTable(String source,
+                      Boolean isAccelerator,
+                      _XtTranslateOp defaultOp,
+                      Boolean *error)
+{
+    TMParseCache entry, *entryPtr;
+    XtTranslations xlations;
+    size_t length;
+
+    if (source == NULL)
+        return (XtTranslations) NULL;
+
+    LOCK_PROCESS;
+    if (parseCacheGeneration != _XtMatchTableGeneration)
+        FlushParseCache();
+    entryPtr = &parseCache[HashSource(source, isAccelerator, defaultOp)];
+    for (entry = *entryPtr; entry; entry = entry->next) {
+        if (entry->isAccelerator == isAccelerator &&
+            entry->defaultOp == defaultOp &&
+            strcmp(entry->source, source) == 0) {
+            UNLOCK_PROCESS;
+            return entry->xlations;
+        }
+    }
+    UNLOCK_PROCESS;
+
+    xlations = ParseTranslationTableSource(source, isAccelerator, defaultOp,
+                                           error);
+    if (*error == TRUE)
+        return xlations;
+
+    length = strlen(source) + 1;
+    entry = (TMParseCache) __XtMalloc((Cardinal) (sizeof(TMParseCacheRec) +
+                                                  length));
+    entry->source = (String) (entry + 1);
+    memcpy(entry->source, source, length);
+    entry->isAccelerator = isAccelerator;
+    entry->defaultOp = defaultOp;
+    entry->xlations = xlations;
+    LOCK_PROCESS;
+    if (parseCacheGeneration != _XtMatchTableGeneration)
+        FlushParseCache();
+    entryPtr = &parseCache[HashSource(source, isAccelerator, defaultOp)];
+    entry->next = *entryPtr;
+    *entryPtr = entry;
+    UNLOCK_PROCESS;
+    return xlations;
+}
+
+#endif
+
 /*** public procedures ***/
 
 Boolean
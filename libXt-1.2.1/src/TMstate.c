@@ -417,17 +417,131 @@ _XtGetModifierIndex(Event *event)
 }
 
 /*
- * This is called from the SimpleStateHandler to match a stateTree
- * entry to the event coming in
+ * Match tables.  Matching an event against the branch heads of a state
+ * tree means calling the match procedure of every head, which for keys
+ * translates the keycode and resolves late-bound modifiers each time.
+ * The outcome only depends on the display, the event type, its detail
+ * and its modifiers, so each state tree gets a table that maps those to
+ * the list of branch heads that match, filled in the first time a
+ * combination is seen.  For key events the table also keeps the keysym
+ * the match procedure left in the display's key context, so that
+ * XtGetActionKeysym still works after a table hit.  Anything that
+ * changes how keys translate (a MappingNotify, a new key translator or
+ * case converter) bumps _XtMatchTableGeneration, which empties the
+ * tables the next time they are used.
  */
-static int
-MatchBranchHead(TMSimpleStateTree stateTree, int startIndex, TMEventPtr event)
+
+typedef struct _TMMatchRec {
+    TMShortCard branchIndex;
+    Boolean keyContext;         /* set the key context on a match */
+    Modifiers modifiers;        /* for the key context */
+    KeySym keysym;              /* for the key context */
+} TMMatchRec, *TMMatch;
+
+typedef struct _TMMatchEntryRec {
+    struct _TMMatchEntryRec *next;
+    Display *dpy;
+    TMLongCard eventType;
+    TMLongCard eventCode;
+    TMLongCard modifiers;
+    TMShortCard numMatches;
+    TMMatch matches;
+} TMMatchEntryRec, *TMMatchEntry;
+
+typedef struct _TMMatchTableRec {
+    struct _TMMatchTableRec *next;
+    TMSimpleStateTree stateTree;
+    unsigned long generation;
+    Cardinal numEntries;
+    TMMatchEntry entries[64];
+} TMMatchTableRec, *TMMatchTable;
+
+#define MATCH_ENTRY_HASH(dpy, type, code, mods) \
+    ((Cardinal) (((unsigned long) (dpy) >> 4) + (type) * 31 + (code) * 7 + \
+                 (mods)) & 63)
+#define MATCH_TABLE_HASH(stateTree) \
+    ((Cardinal) ((unsigned long) (stateTree) >> 4) & 63)
+#define MAX_MATCH_ENTRIES 512   /* per state tree, then start over */
+
+unsigned long _XtMatchTableGeneration;
+
+static TMMatchTable matchTables[64];
+
+static void
+FlushMatchTable(TMMatchTable table)
 {
-    TMBranchHead branchHead = &stateTree->branchHeadTbl[startIndex];
-    int i;
+    Cardinal i;
 
-    LOCK_PROCESS;
-    for (i = startIndex; i < (int) stateTree->numBranchHeads; i++, branchHead++) {
+    for (i = 0; i < XtNumber(table->entries); i++) {
+        TMMatchEntry entry, next;
+
+        for (entry = table->entries[i]; entry; entry = next) {
+            next = entry->next;
+            XtFree((char *) entry);
+        }
+        table->entries[i] = NULL;
+    }
+    table->numEntries = 0;
+    table->generation = _XtMatchTableGeneration;
+}
+
+static TMMatchTable
+GetMatchTable(TMSimpleStateTree stateTree)
+{
+    TMMatchTable *tablePtr = &matchTables[MATCH_TABLE_HASH(stateTree)];
+    TMMatchTable table;
+
+    for (table = *tablePtr; table; table = table->next)
+        if (table->stateTree == stateTree)
+            break;
+    if (table == NULL) {
+        table = XtNew(TMMatchTableRec);
+        memset(table, 0, sizeof(TMMatchTableRec));
+        table->stateTree = stateTree;
+        table->generation = _XtMatchTableGeneration;
+        table->next = *tablePtr;
+        *tablePtr = table;
+    }
+    else if (table->generation != _XtMatchTableGeneration)
+        FlushMatchTable(table);
+    return table;
+}
+
+#ifdef REFCNT_TRANSLATIONS
+static void
+RemoveMatchTable(TMSimpleStateTree stateTree)
+{
+    TMMatchTable *tablePtr = &matchTables[MATCH_TABLE_HASH(stateTree)];
+    TMMatchTable table;
+
+    for (; (table = *tablePtr); tablePtr = &table->next) {
+        if (table->stateTree == stateTree) {
+            *tablePtr = table->next;
+            FlushMatchTable(table);
+            XtFree((char *) table);
+            return;
+        }
+    }
+}
+#endif                          /* REFCNT_TRANSLATIONS */
+
+/*
+ * Runs the match procedure of every branch head against the event and
+ * records the heads that matched.
+ */
+static TMMatchEntry
+CompileMatchEntry(TMSimpleStateTree stateTree, TMEventPtr event)
+{
+    TMBranchHead branchHead = stateTree->branchHeadTbl;
+    TMMatchEntry entry;
+    TMShortCard i, numMatches = 0;
+
+    entry = (TMMatchEntry)
+        __XtMalloc((Cardinal) (sizeof(TMMatchEntryRec) +
+                               stateTree->numBranchHeads *
+                               sizeof(TMMatchRec)));
+    entry->matches = (TMMatch) (entry + 1);
+    for (i = 0; i < stateTree->numBranchHeads; i++, branchHead++) {
         TMTypeMatch typeMatch;
         TMModifierMatch modMatch;
 
@@ -435,10 +549,101 @@ MatchBranchHead(TMSimpleStateTree stateTree, int startIndex, TMEventPtr event)
         modMatch = TMGetModifierMatch(branchHead->modIndex);
 
         if (MatchIncomingEvent(event, typeMatch, modMatch)) {
-            UNLOCK_PROCESS;
-            return i;
+            TMMatch match = &entry->matches[numMatches++];
+
+            match->branchIndex = i;
+            match->keyContext =
+                (typeMatch->matchEvent == _XtMatchUsingStandardMods ||
+                 typeMatch->matchEvent == _XtMatchUsingDontCareMods);
+            if (match->keyContext) {
+                TMKeyContext tm_context =
+                    _XtGetPerDisplay(event->xev->xany.display)->tm_context;
+
+                match->keysym = tm_context->keysym;
+                match->modifiers = tm_context->modifiers;
+            }
+            else {
+                match->keysym = NoSymbol;
+                match->modifiers = 0;
+            }
         }
     }
+    if (numMatches < stateTree->numBranchHeads) {
+        entry = (TMMatchEntry)
+            XtRealloc((char *) entry,
+                      (Cardinal) (sizeof(TMMatchEntryRec) +
+                                  numMatches * sizeof(TMMatchRec)));
+        entry->matches = (TMMatch) (entry + 1);
+    }
+    entry->dpy = event->xev->xany.display;
+    entry->eventType = event->event.eventType;
+    entry->eventCode = event->event.eventCode;
+    entry->modifiers = event->event.modifiers;
+    entry->numMatches = numMatches;
+    return entry;
+}
+
+static TMMatchEntry
+LookupMatchEntry(TMSimpleStateTree stateTree, TMEventPtr event)
+{
+    TMMatchTable table = GetMatchTable(stateTree);
+    Display *dpy = event->xev->xany.display;
+    TMMatchEntry *entryPtr, entry;
+
+    entryPtr = &table->entries[MATCH_ENTRY_HASH(dpy,
+                                                event->event.eventType,
+                                                event->event.eventCode,
+                                                event->event.modifiers)];
+    for (entry = *entryPtr; entry; entry = entry->next) {
+        if (entry->dpy == dpy &&
+            entry->eventType == event->event.eventType &&
+            entry->eventCode == event->event.eventCode &&
+            entry->modifiers == event->event.modifiers)
+            return entry;
+    }
+    if (table->numEntries >= MAX_MATCH_ENTRIES) {
+        FlushMatchTable(table);
+        entryPtr = &table->entries[MATCH_ENTRY_HASH(dpy,
+                                                    event->event.eventType,
+                                                    event->event.eventCode,
+                                                    event->event.modifiers)];
+    }
+    entry = CompileMatchEntry(stateTree, event);
+    entry->next = *entryPtr;
+    *entryPtr = entry;
+    table->numEntries++;
+    return entry;
+}
+
+/*
+ * This is called from the SimpleStateHandler to match a stateTree
+ * entry to the event coming in
+ */
+static int
+MatchBranchHead(TMSimpleStateTree stateTree, int startIndex, TMEventPtr event)
+{
+    TMMatchEntry entry;
+    TMShortCard i;
+
+    LOCK_PROCESS;
+    entry = LookupMatchEntry(stateTree, event);
+    for (i = 0; i < entry->numMatches; i++) {
+        TMMatch match = &entry->matches[i];
+
+        if ((int) match->branchIndex < startIndex)
+            continue;
+        if (match->keyContext) {
+            TMKeyContext tm_context =
+                _XtGetPerDisplay(event->xev->xany.display)->tm_context;
+
+            tm_context->event = event->xev;
+            tm_context->serial = event->xev->xany.serial;
+            tm_context->keysym = match->keysym;
+            tm_context->modifiers = match->modifiers;
+        }
+        UNLOCK_PROCESS;
+        return match->branchIndex;
+    }
     UNLOCK_PROCESS;
     return (TM_NO_MATCH);
 }
@@ -2087,6 +2292,7 @@ RemoveStateTree(TMStateTree tree _X_UNUSED)
     TMComplexStateTree stateTree = (TMComplexStateTree) tree;
 
     if (--stateTree->refCount == 0) {
+        RemoveMatchTable((TMSimpleStateTree) stateTree);
         /*
          * should we free/refcount the match recs ?
          */
@@ -105,7 +105,7 @@ extensions.append(extension)
 extension = Extension("guitk.events_tcltk",
                       event_tcltk_sources,
                       include_dirs=include_dirs+["/usr/include/tcl8.6/tcl-private/generic/", "/usr/include/tcl8.6/tcl-private/unix/", "/usr/include/tcl8.6/tk-private/generic/", "/usr/include/tcl8.6/tk-private/unix/", "libXt-1.2.1/include/X11/", "/usr/include/X11"],
-                      extra_link_args=extra_link_args + ["-ltcl8.6", "/usr/lib/python3.12/lib-dynload/_tkinter.cpython-312-x86_64-linux-gnu.so", "-lICE", "-lSM"],
+                      extra_link_args=extra_link_args + ["-ltcl8.6", "-ltk8.6", "/usr/lib/python3.12/lib-dynload/_tkinter.cpython-312-x86_64-linux-gnu.so", "-lICE", "-lSM"],
                       )
 
 extensions.append(extension)